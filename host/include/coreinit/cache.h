@@ -0,0 +1,18 @@
+#pragma once
+
+#include <wut_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The host has coherent caches, these are no-ops.
+void DCFlushRange(void *addr, uint32_t size);
+void DCStoreRange(void *addr, uint32_t size);
+void DCInvalidateRange(void *addr, uint32_t size);
+void ICInvalidateRange(void *addr, uint32_t size);
+void OSMemoryBarrier();
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <wut_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Prints to stderr.
+void OSReport(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Prints the message to stderr and aborts.
+void OSFatal(const char *msg) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
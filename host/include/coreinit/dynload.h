@@ -0,0 +1,35 @@
+#pragma once
+
+#include <wut_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *OSDynLoad_Module;
+
+typedef enum OSDynLoad_Error {
+    OS_DYNLOAD_OK                    = 0,
+    OS_DYNLOAD_OUT_OF_MEMORY         = 0xBAD10002,
+    OS_DYNLOAD_INVALID_MODULE_NAME   = 0xBAD10014,
+    OS_DYNLOAD_INVALID_ALLOCATOR_PTR = 0xBAD10017,
+} OSDynLoad_Error;
+
+typedef enum OSDynLoad_ExportType {
+    OS_DYNLOAD_EXPORT_FUNC = 0,
+    OS_DYNLOAD_EXPORT_DATA = 1,
+} OSDynLoad_ExportType;
+
+typedef OSDynLoad_Error (*OSDynLoadAllocFn)(int32_t size, int32_t align, void **outAddr);
+typedef void (*OSDynLoadFreeFn)(void *addr);
+
+// There are no RPLs on the host, acquiring a module always fails.
+OSDynLoad_Error OSDynLoad_Acquire(const char *name, OSDynLoad_Module *outModule);
+OSDynLoad_Error OSDynLoad_FindExport(OSDynLoad_Module module, OSDynLoad_ExportType exportType, const char *name, void **outAddr);
+void OSDynLoad_Release(OSDynLoad_Module module);
+OSDynLoad_Error OSDynLoad_GetAllocator(OSDynLoadAllocFn *outAllocFn, OSDynLoadFreeFn *outFreeFn);
+OSDynLoad_Error OSDynLoad_SetAllocator(OSDynLoadAllocFn allocFn, OSDynLoadFreeFn freeFn);
+
+#ifdef __cplusplus
+}
+#endif
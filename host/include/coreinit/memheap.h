@@ -0,0 +1,5 @@
+#pragma once
+
+#include <wut_types.h>
+
+// Included by the plugin loading code, but none of the heap functions are used on the host.
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <coreinit/time.h>
+#include <wut_types.h>
+
+// Only the types that are referenced by the portable code, threads are std::thread on the host.
+
+typedef struct OSThread OSThread;
+
+typedef uint8_t OSThreadAttributes;
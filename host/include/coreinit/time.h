@@ -0,0 +1,28 @@
+#pragma once
+
+#include <wut_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int64_t OSTime;
+typedef int32_t OSTick;
+
+// On the host one tick is one nanosecond of a monotonic clock.
+OSTime OSGetSystemTime();
+OSTime OSGetTime();
+OSTick OSGetSystemTick();
+
+#define OSTicksToSeconds(val)      ((val) / 1000000000ll)
+#define OSTicksToMilliseconds(val) ((val) / 1000000ll)
+#define OSTicksToMicroseconds(val) ((val) / 1000ll)
+#define OSTicksToNanoseconds(val)  (val)
+#define OSSecondsToTicks(val)      ((int64_t) (val) * 1000000000ll)
+#define OSMillisecondsToTicks(val) ((int64_t) (val) * 1000000ll)
+#define OSMicrosecondsToTicks(val) ((int64_t) (val) * 1000ll)
+#define OSNanosecondsToTicks(val)  ((int64_t) (val))
+
+#ifdef __cplusplus
+}
+#endif
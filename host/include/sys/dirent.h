@@ -0,0 +1,4 @@
+#pragma once
+
+// newlib declares the dirent functions in sys/dirent.h, glibc in dirent.h
+#include <dirent.h>
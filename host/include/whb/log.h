@@ -0,0 +1,13 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Prints to stderr.
+int WHBLogPrintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+int WHBLogWritef(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,97 @@
+#include <chrono>
+#include <coreinit/cache.h>
+#include <coreinit/debug.h>
+#include <coreinit/dynload.h>
+#include <coreinit/time.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <whb/log.h>
+
+void DCFlushRange(void *, uint32_t) {
+}
+
+void DCStoreRange(void *, uint32_t) {
+}
+
+void DCInvalidateRange(void *, uint32_t) {
+}
+
+void ICInvalidateRange(void *, uint32_t) {
+}
+
+void OSMemoryBarrier() {
+    __sync_synchronize();
+}
+
+void OSReport(const char *fmt, ...) {
+    va_list va;
+    va_start(va, fmt);
+    vfprintf(stderr, fmt, va);
+    va_end(va);
+}
+
+void OSFatal(const char *msg) {
+    fprintf(stderr, "OSFatal: %s\n", msg);
+    abort();
+}
+
+int WHBLogPrintf(const char *fmt, ...) {
+    va_list va;
+    va_start(va, fmt);
+    int res = vfprintf(stderr, fmt, va);
+    va_end(va);
+    fputc('\n', stderr);
+    return res;
+}
+
+int WHBLogWritef(const char *fmt, ...) {
+    va_list va;
+    va_start(va, fmt);
+    int res = vfprintf(stderr, fmt, va);
+    va_end(va);
+    return res;
+}
+
+OSTime OSGetSystemTime() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+OSTime OSGetTime() {
+    return OSGetSystemTime();
+}
+
+OSTick OSGetSystemTick() {
+    return (OSTick) OSGetSystemTime();
+}
+
+OSDynLoad_Error OSDynLoad_Acquire(const char *, OSDynLoad_Module *outModule) {
+    if (outModule) {
+        *outModule = nullptr;
+    }
+    return OS_DYNLOAD_INVALID_MODULE_NAME;
+}
+
+OSDynLoad_Error OSDynLoad_FindExport(OSDynLoad_Module, OSDynLoad_ExportType, const char *, void **outAddr) {
+    if (outAddr) {
+        *outAddr = nullptr;
+    }
+    return OS_DYNLOAD_INVALID_MODULE_NAME;
+}
+
+void OSDynLoad_Release(OSDynLoad_Module) {
+}
+
+OSDynLoad_Error OSDynLoad_GetAllocator(OSDynLoadAllocFn *outAllocFn, OSDynLoadFreeFn *outFreeFn) {
+    if (outAllocFn) {
+        *outAllocFn = nullptr;
+    }
+    if (outFreeFn) {
+        *outFreeFn = nullptr;
+    }
+    return OS_DYNLOAD_OK;
+}
+
+OSDynLoad_Error OSDynLoad_SetAllocator(OSDynLoadAllocFn, OSDynLoadFreeFn) {
+    return OS_DYNLOAD_OK;
+}
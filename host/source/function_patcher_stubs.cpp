@@ -0,0 +1,19 @@
+#include <function_patcher/function_patching.h>
+
+// Nothing can be patched on the host, patches are only tracked by handle.
+
+static PatchedFunctionHandle sNextHandle = 1;
+
+FunctionPatcherStatus FunctionPatcher_AddFunctionPatch(function_replacement_data_t *, PatchedFunctionHandle *outHandle, bool *outHasBeenPatched) {
+    if (outHandle) {
+        *outHandle = sNextHandle++;
+    }
+    if (outHasBeenPatched) {
+        *outHasBeenPatched = false;
+    }
+    return FUNCTION_PATCHER_RESULT_SUCCESS;
+}
+
+FunctionPatcherStatus FunctionPatcher_RemoveFunctionPatch(PatchedFunctionHandle) {
+    return FUNCTION_PATCHER_RESULT_SUCCESS;
+}
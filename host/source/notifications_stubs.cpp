@@ -0,0 +1,14 @@
+#include "NotificationsUtils.h"
+#include <cstdio>
+
+// The notification module is not available on the host, print the notifications instead.
+
+bool DisplayInfoNotificationMessage(std::string_view text, float) {
+    fprintf(stderr, "[Notification] %.*s\n", (int) text.size(), text.data());
+    return true;
+}
+
+bool DisplayErrorNotificationMessage(std::string_view text, float) {
+    fprintf(stderr, "[Error notification] %.*s\n", (int) text.size(), text.data());
+    return true;
+}
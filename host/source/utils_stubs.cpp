@@ -0,0 +1,8 @@
+#include "utils/utils.h"
+#include <cstdlib>
+
+// The plugin path is read from the environment loader on the console, use $WUPS_PLUGIN_PATH (or ./plugins) instead.
+std::string getPluginPath() {
+    const char *path = getenv("WUPS_PLUGIN_PATH");
+    return path != nullptr ? path : "plugins";
+}
@@ -0,0 +1,43 @@
+#include "TestUtils.h"
+#include "plugin/PluginDataFactory.h"
+#include "plugin/PluginInformationFactory.h"
+#include "plugin/PluginMetaInformationFactory.h"
+#include <vector>
+
+// Linking writes the addresses of the sections into 32 bit relocations.
+static_assert(sizeof(void *) == sizeof(uint32_t), "The host tests need a 32 bit build, see ARCHFLAGS in host/Makefile");
+
+// Same as TRAMP_DATA_SIZE of the backend.
+#define TRAMP_DATA_SIZE 1024
+
+/**
+ * Loads and links a plugin the same way the backend does: read it into memory, parse the meta information and
+ * link it with a trampoline id. Expects the path of a plugin generated by tools/wpsgen.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <plugin.wps>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto pluginData = PluginDataFactory::load(argv[1]);
+    CHECK(pluginData != nullptr);
+
+    PluginParseErrors error = PLUGIN_PARSE_ERROR_UNKNOWN;
+    auto metaInfo           = PluginMetaInformationFactory::loadPlugin(*pluginData, error);
+    CHECK(metaInfo.has_value());
+    CHECK(error == PLUGIN_PARSE_ERROR_NONE);
+    CHECK(!metaInfo->getName().empty());
+
+    std::vector<relocation_trampoline_entry_t> trampData(TRAMP_DATA_SIZE);
+    for (auto &cur : trampData) {
+        cur.status = RELOC_TRAMP_FREE;
+    }
+    auto pluginInfo = PluginInformationFactory::load(*pluginData, trampData, 1);
+    CHECK(pluginInfo.has_value());
+    CHECK(pluginInfo->getTrampolineId() == 1);
+    CHECK(pluginInfo->getSectionInfo(".text").has_value());
+
+    printf("PluginLoadTest: OK\n");
+    return EXIT_SUCCESS;
+}
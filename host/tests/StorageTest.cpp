@@ -0,0 +1,207 @@
+#include "TestUtils.h"
+#include "fs/FSUtils.h"
+#include "utils/TaskRuntime.h"
+#include "utils/storage/StorageUtils.h"
+#include "utils/utils.h"
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace StorageUtils::API;
+
+// Normally provided by the WUPS library.
+const char *WUPSStorageAPI_GetStatusStr(WUPSStorageError) {
+    return "";
+}
+
+namespace {
+    std::string GetConfigFilePath(std::string_view fileName) {
+        return getPluginPath() + "/config/" + fileName.data();
+    }
+
+    void WriteFile(const std::string &path, std::span<const uint8_t> data) {
+        FILE *file = fopen(path.c_str(), "wb");
+        CHECK(file != nullptr);
+        CHECK(fwrite(data.data(), 1, data.size(), file) == data.size());
+        fclose(file);
+    }
+
+    std::vector<uint8_t> ReadFile(const std::string &path) {
+        std::vector<uint8_t> buffer;
+        CHECK(FSUtils::LoadFileToMem(path, buffer) >= 0);
+        return buffer;
+    }
+
+    bool FileExists(const std::string &path) {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (file) {
+            fclose(file);
+        }
+        return file != nullptr;
+    }
+
+    void TestRoundTrip() {
+        wups_storage_root_item root;
+        CHECK_SUCCESS(Internal::OpenStorage("round_trip", root));
+
+        int32_t value = 42;
+        CHECK_SUCCESS(StoreItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &value, sizeof(value)));
+        double number = 1.5;
+        CHECK_SUCCESS(StoreItem(root, nullptr, "number", WUPS_STORAGE_ITEM_DOUBLE, &number, sizeof(number)));
+        wups_storage_item sub;
+        CHECK_SUCCESS(CreateSubItem(root, nullptr, "sub", &sub));
+        CHECK_SUCCESS(StoreItem(root, sub, "string", WUPS_STORAGE_ITEM_STRING, (void *) "hello", 5));
+        // Bigger than the inline size of a value.
+        uint8_t binary[100];
+        for (uint32_t i = 0; i < sizeof(binary); i++) {
+            binary[i] = (uint8_t) (i * 7);
+        }
+        CHECK_SUCCESS(StoreItem(root, sub, "binary", WUPS_STORAGE_ITEM_BINARY, binary, sizeof(binary)));
+
+        CHECK_SUCCESS(SaveStorage(root, false));
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+
+        CHECK_SUCCESS(Internal::OpenStorage("round_trip", root));
+        uint32_t size;
+        int32_t valueRead = 0;
+        CHECK_SUCCESS(GetItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &valueRead, sizeof(valueRead), &size));
+        CHECK(valueRead == value);
+        double numberRead = 0;
+        CHECK_SUCCESS(GetItem(root, nullptr, "number", WUPS_STORAGE_ITEM_DOUBLE, &numberRead, sizeof(numberRead), &size));
+        CHECK(numberRead == number);
+        CHECK_SUCCESS(GetSubItem(root, nullptr, "sub", &sub));
+        char string[16] = {};
+        CHECK_SUCCESS(GetItem(root, sub, "string", WUPS_STORAGE_ITEM_STRING, string, sizeof(string), &size));
+        CHECK(strcmp(string, "hello") == 0);
+        uint8_t binaryRead[sizeof(binary)] = {};
+        CHECK_SUCCESS(GetItem(root, sub, "binary", WUPS_STORAGE_ITEM_BINARY, binaryRead, sizeof(binaryRead), &size));
+        CHECK(size == sizeof(binary) && memcmp(binaryRead, binary, sizeof(binary)) == 0);
+
+        // Unsaved changes are dropped by a reload.
+        CHECK_SUCCESS(DeleteItem(root, nullptr, "number"));
+        CHECK_SUCCESS(ForceReloadStorage(root));
+        CHECK_SUCCESS(GetItem(root, nullptr, "number", WUPS_STORAGE_ITEM_DOUBLE, &numberRead, sizeof(numberRead), &size));
+
+        CHECK_SUCCESS(WipeStorage(root));
+        CHECK(GetItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &valueRead, sizeof(valueRead), &size) == WUPS_STORAGE_ERROR_NOT_FOUND);
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+    }
+
+    void TestJSONExport() {
+        Internal::SetJSONExport(true);
+        wups_storage_root_item root;
+        CHECK_SUCCESS(Internal::OpenStorage("exported", root));
+        // Invalid UTF-8 sequences are dropped, the rest of the string is kept.
+        const char string[] = "a\xff\"b\xc3\xa4\xe2\x82\n\xed\xa0\x80" "c\xc3";
+        CHECK_SUCCESS(StoreItem(root, nullptr, "string", WUPS_STORAGE_ITEM_STRING, (void *) string, strlen(string)));
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+        Internal::SetJSONExport(false);
+
+        // Only the JSON storage is left.
+        CHECK(remove(GetConfigFilePath("exported.bin").c_str()) == 0);
+        CHECK_SUCCESS(Internal::OpenStorage("exported", root));
+        uint32_t size;
+        char stringRead[32] = {};
+        CHECK_SUCCESS(GetItem(root, nullptr, "string", WUPS_STORAGE_ITEM_STRING, stringRead, sizeof(stringRead), &size));
+        CHECK(strcmp(stringRead, "a\"b\xc3\xa4\n" "c") == 0);
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+    }
+
+    void TestJSONMigration() {
+        // Storages of older versions, the last value of a duplicate key wins.
+        const char json[] = R"({"storageitems": {"value": 1, "sub": {"string": "old"}, "value": 2}})";
+        WriteFile(GetConfigFilePath("migrated.json"), std::span((const uint8_t *) json, strlen(json)));
+
+        wups_storage_root_item root;
+        CHECK_SUCCESS(Internal::OpenStorage("migrated", root));
+        uint32_t size;
+        int32_t value = 0;
+        CHECK_SUCCESS(GetItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &value, sizeof(value), &size));
+        CHECK(value == 2);
+        wups_storage_item sub;
+        CHECK_SUCCESS(GetSubItem(root, nullptr, "sub", &sub));
+        char string[16] = {};
+        CHECK_SUCCESS(GetItem(root, sub, "string", WUPS_STORAGE_ITEM_STRING, string, sizeof(string), &size));
+        CHECK(strcmp(string, "old") == 0);
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+    }
+
+    void TestInterruptedSave() {
+        wups_storage_root_item root;
+        CHECK_SUCCESS(Internal::OpenStorage("interrupted", root));
+        int32_t value = 7;
+        CHECK_SUCCESS(StoreItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &value, sizeof(value)));
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+
+        auto binPath = GetConfigFilePath("interrupted.bin");
+        auto tmpPath = binPath + ".tmp";
+        auto binary  = ReadFile(binPath);
+        CHECK(remove(binPath.c_str()) == 0);
+
+        // The old file has been removed, but the new one is complete.
+        WriteFile(tmpPath, binary);
+        CHECK_SUCCESS(Internal::OpenStorage("interrupted", root));
+        uint32_t size;
+        int32_t valueRead = 0;
+        CHECK_SUCCESS(GetItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &valueRead, sizeof(valueRead), &size));
+        CHECK(valueRead == value);
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        CHECK(FileExists(binPath) && !FileExists(tmpPath));
+
+        // The first save of a storage has been cut off.
+        CHECK(remove(binPath.c_str()) == 0);
+        WriteFile(tmpPath, std::span(binary).first(binary.size() - 2));
+        CHECK_SUCCESS(Internal::OpenStorage("interrupted", root));
+        CHECK(GetItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &valueRead, sizeof(valueRead), &size) == WUPS_STORAGE_ERROR_NOT_FOUND);
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        CHECK(!FileExists(binPath) && !FileExists(tmpPath));
+    }
+
+    void TestJSONBackup() {
+        wups_storage_root_item root;
+        CHECK_SUCCESS(Internal::OpenStorage("backup", root));
+        int32_t value = 5;
+        CHECK_SUCCESS(StoreItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &value, sizeof(value)));
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+
+        // A truncated binary storage next to the JSON storage it has been migrated from.
+        auto binPath = GetConfigFilePath("backup.bin");
+        auto binary  = ReadFile(binPath);
+        WriteFile(binPath, std::span(binary).first(binary.size() - 2));
+        const char json[] = R"({"storageitems": {"value": 3}})";
+        WriteFile(GetConfigFilePath("backup.json"), std::span((const uint8_t *) json, strlen(json)));
+
+        CHECK_SUCCESS(Internal::OpenStorage("backup", root));
+        uint32_t size;
+        int32_t valueRead = 0;
+        CHECK_SUCCESS(GetItem(root, nullptr, "value", WUPS_STORAGE_ITEM_S32, &valueRead, sizeof(valueRead), &size));
+        CHECK(valueRead == 3);
+        // Replaces the truncated binary storage.
+        CHECK_SUCCESS(Internal::CloseStorage(root));
+        Internal::FlushStorage();
+        CHECK(ReadFile(binPath).size() == binary.size());
+    }
+} // namespace
+
+int main() {
+    CHECK(FSUtils::CreateSubfolder(getPluginPath() + "/config"));
+    CHECK(TaskRuntime::Start());
+
+    TestRoundTrip();
+    TestJSONExport();
+    TestJSONMigration();
+    TestInterruptedSave();
+    TestJSONBackup();
+
+    TaskRuntime::Shutdown();
+    printf("StorageTest: OK\n");
+    return EXIT_SUCCESS;
+}
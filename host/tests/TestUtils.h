@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Minimal checks for the host tests, the first failed check prints its location and ends the test.
+ */
+#define CHECK(cond)                                                                      \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);     \
+            _Exit(EXIT_FAILURE);                                                         \
+        }                                                                                \
+    } while (0)
+
+#define CHECK_SUCCESS(expr) CHECK((expr) == WUPS_STORAGE_ERROR_SUCCESS)
@@ -13,16 +13,34 @@
 #include <memory>
 
 std::vector<PluginContainer>
-PluginManagement::loadPlugins(const std::set<std::shared_ptr<PluginData>> &pluginDataList, std::vector<relocation_trampoline_entry_t> &trampolineData) {
+PluginManagement::layoutPlugins(const std::set<std::shared_ptr<PluginData>> &pluginDataList,
+                                std::vector<relocation_trampoline_entry_t> &trampolineData,
+                                std::span<const PluginContainer> alreadyLoadedPlugins) {
     std::vector<PluginContainer> plugins;
 
+    std::set<uint32_t> usedTrampolineIds;
+    for (const auto &plugin : alreadyLoadedPlugins) {
+        usedTrampolineIds.insert(plugin.getPluginInformation().getTrampolineId());
+    }
+
+    // Trampoline ids are 8 bit, wider so running out of ids can be detected.
     uint32_t trampolineID = 0;
     for (const auto &pluginData : pluginDataList) {
         PluginParseErrors error = PLUGIN_PARSE_ERROR_UNKNOWN;
 
         auto metaInfo = PluginMetaInformationFactory::loadPlugin(*pluginData, error);
         if (metaInfo && error == PLUGIN_PARSE_ERROR_NONE) {
-            auto info = PluginInformationFactory::load(*pluginData, trampolineData, trampolineID++);
+            // Trampolines of plugins that stay loaded are identified by their id, don't hand it out twice.
+            while (trampolineID <= UINT8_MAX && usedTrampolineIds.contains(trampolineID)) {
+                trampolineID++;
+            }
+            if (trampolineID > UINT8_MAX) {
+                auto errMsg = string_format("Failed to load plugin: %s. No free trampoline id left.", pluginData->getSource().c_str());
+                DEBUG_FUNCTION_LINE_ERR("%s", errMsg.c_str());
+                DisplayErrorNotificationMessage(errMsg, 15.0f);
+                continue;
+            }
+            auto info = PluginInformationFactory::load(*pluginData, trampolineData, (uint8_t) trampolineID++);
             if (!info) {
                 auto errMsg = string_format("Failed to load plugin: %s", pluginData->getSource().c_str());
                 DEBUG_FUNCTION_LINE_ERR("%s", errMsg.c_str());
@@ -40,6 +58,15 @@ PluginManagement::loadPlugins(const std::set<std::shared_ptr<PluginData>> &plugi
         }
     }
 
+    return plugins;
+}
+
+std::vector<PluginContainer>
+PluginManagement::loadPlugins(const std::set<std::shared_ptr<PluginData>> &pluginDataList,
+                              std::vector<relocation_trampoline_entry_t> &trampolineData,
+                              std::span<const PluginContainer> alreadyLoadedPlugins) {
+    auto plugins = layoutPlugins(pluginDataList, trampolineData, alreadyLoadedPlugins);
+
     if (!PluginManagement::DoFunctionPatches(plugins)) {
         DEBUG_FUNCTION_LINE_ERR("Failed to patch functions");
         OSFatal("WiiUPluginLoaderBackend: Failed to patch functions");
@@ -48,6 +75,55 @@ PluginManagement::loadPlugins(const std::set<std::shared_ptr<PluginData>> &plugi
     return plugins;
 }
 
+void PluginManagement::diffPlugins(std::vector<PluginContainer> &&loadedPlugins,
+                                   const std::set<std::shared_ptr<PluginData>> &pluginDataList,
+                                   std::vector<PluginContainer> &outPluginsToKeep,
+                                   std::vector<PluginContainer> &outPluginsToUnload,
+                                   std::set<std::shared_ptr<PluginData>> &outPluginDataToLoad) {
+    std::vector<bool> keepPlugin(loadedPlugins.size(), false);
+
+    for (const auto &pluginData : pluginDataList) {
+        bool found = false;
+        for (size_t i = 0; i < loadedPlugins.size(); i++) {
+            if (keepPlugin[i]) {
+                continue;
+            }
+            auto loadedData = loadedPlugins[i].getPluginDataCopy();
+            if (loadedData == pluginData || loadedData->hasSameContent(*pluginData)) {
+                keepPlugin[i] = true;
+                found         = true;
+                break;
+            }
+        }
+        if (!found) {
+            outPluginDataToLoad.insert(pluginData);
+        }
+    }
+
+    for (size_t i = 0; i < loadedPlugins.size(); i++) {
+        if (keepPlugin[i]) {
+            DEBUG_FUNCTION_LINE_VERBOSE("Keep plugin %s", loadedPlugins[i].getMetaInformation().getName().c_str());
+            outPluginsToKeep.push_back(std::move(loadedPlugins[i]));
+        } else {
+            DEBUG_FUNCTION_LINE_VERBOSE("Unload plugin %s", loadedPlugins[i].getMetaInformation().getName().c_str());
+            outPluginsToUnload.push_back(std::move(loadedPlugins[i]));
+        }
+    }
+    loadedPlugins.clear();
+}
+
+void PluginManagement::freeTrampolines(std::span<const PluginContainer> plugins, std::vector<relocation_trampoline_entry_t> &trampData) {
+    std::set<uint8_t> trampolineIds;
+    for (const auto &plugin : plugins) {
+        trampolineIds.insert(plugin.getPluginInformation().getTrampolineId());
+    }
+    for (auto &cur : trampData) {
+        if (cur.status != RELOC_TRAMP_FREE && trampolineIds.contains(cur.id)) {
+            cur.status = RELOC_TRAMP_FREE;
+        }
+    }
+}
+
 bool PluginManagement::doRelocation(const std::vector<RelocationData> &relocData,
                                     std::vector<relocation_trampoline_entry_t> &trampData,
                                     uint32_t trampolineID,
@@ -137,6 +213,11 @@ bool PluginManagement::doRelocations(const std::vector<PluginContainer> &plugins
     OSDynLoad_SetAllocator(CustomDynLoadAlloc, CustomDynLoadFree);
 
     for (const auto &pluginContainer : plugins) {
+        // The trampolines of all imports have been freed above. Initialized plugins keep their imports even while inactive,
+        // WUPS_LOADER_HOOK_DEINIT_PLUGIN is called for them when they are unloaded.
+        if (!pluginContainer.isActive() && !pluginContainer.isInitialized()) {
+            continue;
+        }
         DEBUG_FUNCTION_LINE_VERBOSE("Doing relocations for plugin: %s", pluginContainer.getMetaInformation().getName().c_str());
         if (!PluginManagement::doRelocation(pluginContainer.getPluginInformation().getRelocationDataList(),
                                             trampData,
@@ -174,10 +255,26 @@ bool PluginManagement::DoFunctionPatches(std::vector<PluginContainer> &plugins)
     return true;
 }
 
-void PluginManagement::callInitHooks(const std::vector<PluginContainer> &plugins) {
-    CallHook(plugins, WUPS_LOADER_HOOK_INIT_CONFIG);
-    CallHook(plugins, WUPS_LOADER_HOOK_INIT_STORAGE_DEPRECATED);
-    CallHook(plugins, WUPS_LOADER_HOOK_INIT_STORAGE);
-    CallHook(plugins, WUPS_LOADER_HOOK_INIT_PLUGIN);
+void PluginManagement::updateActivation(std::vector<PluginContainer> &plugins, uint64_t titleId) {
+    for (auto &plugin : plugins) {
+        bool active = plugin.getMetaInformation().isActiveForTitle(titleId);
+        if (active == plugin.isActive()) {
+            continue;
+        }
+        DEBUG_FUNCTION_LINE("%s plugin %s for title %016llX", active ? "Activate" : "Deactivate", plugin.getMetaInformation().getName().c_str(), titleId);
+        for (auto &curFunction : plugin.getPluginInformation().getFunctionDataList()) {
+            if (active ? !curFunction.AddPatch() : !curFunction.RemovePatch()) {
+                DEBUG_FUNCTION_LINE_ERR("Failed to update function patch for: plugin %s", plugin.getMetaInformation().getName().c_str());
+            }
+        }
+        plugin.setActive(active);
+    }
+}
+
+void PluginManagement::callInitHooks(const HookDispatchTable &hooks) {
+    CallHook(hooks, WUPS_LOADER_HOOK_INIT_CONFIG);
+    CallHook(hooks, WUPS_LOADER_HOOK_INIT_STORAGE_DEPRECATED);
+    CallHook(hooks, WUPS_LOADER_HOOK_INIT_STORAGE);
+    CallHook(hooks, WUPS_LOADER_HOOK_INIT_PLUGIN);
     DEBUG_FUNCTION_LINE_VERBOSE("Done calling init hooks");
 }
\ No newline at end of file
@@ -1,19 +1,50 @@
 #pragma once
 
+#include "plugin/HookDispatchTable.h"
 #include "plugin/PluginContainer.h"
 #include <coreinit/dynload.h>
 #include <map>
 #include <memory>
 #include <set>
+#include <span>
 #include <wums/defines/relocation_defines.h>
 
 class PluginManagement {
 public:
+    /**
+     * Parses the plugins and copies them into their final memory location, but doesn't patch any functions yet.
+     * Plugins that fail to load are skipped.
+     */
+    static std::vector<PluginContainer> layoutPlugins(
+            const std::set<std::shared_ptr<PluginData>> &pluginDataList,
+            std::vector<relocation_trampoline_entry_t> &trampolineData,
+            std::span<const PluginContainer> alreadyLoadedPlugins = {});
+
     static std::vector<PluginContainer> loadPlugins(
             const std::set<std::shared_ptr<PluginData>> &pluginDataList,
-            std::vector<relocation_trampoline_entry_t> &trampolineData);
+            std::vector<relocation_trampoline_entry_t> &trampolineData,
+            std::span<const PluginContainer> alreadyLoadedPlugins = {});
+
+    /**
+     * Compares the currently loaded plugins with the plugin set that should be loaded next.
+     * Plugins whose content is part of the new set are moved to outPluginsToKeep, all others are moved to outPluginsToUnload.
+     * Plugin data of the new set that is not loaded yet is returned via outPluginDataToLoad.
+     */
+    static void diffPlugins(std::vector<PluginContainer> &&loadedPlugins,
+                            const std::set<std::shared_ptr<PluginData>> &pluginDataList,
+                            std::vector<PluginContainer> &outPluginsToKeep,
+                            std::vector<PluginContainer> &outPluginsToUnload,
+                            std::set<std::shared_ptr<PluginData>> &outPluginDataToLoad);
+
+    static void freeTrampolines(std::span<const PluginContainer> plugins, std::vector<relocation_trampoline_entry_t> &trampData);
+
+    static void callInitHooks(const HookDispatchTable &hooks);
 
-    static void callInitHooks(const std::vector<PluginContainer> &plugins);
+    /**
+     * Activates or deactivates each plugin for the given title, based on its meta information.
+     * The function patches of plugins that became inactive are removed, the ones of plugins that became active are added again.
+     */
+    static void updateActivation(std::vector<PluginContainer> &plugins, uint64_t titleId);
 
     static bool doRelocations(const std::vector<PluginContainer> &plugins,
                               std::vector<relocation_trampoline_entry_t> &trampData,
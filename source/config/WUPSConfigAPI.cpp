@@ -6,6 +6,7 @@
 #include "WUPSConfigItemV2.h"
 #include "globals.h"
 #include "plugin/PluginConfigData.h"
+#include "plugin/PluginRegistry.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 #include <algorithm>
@@ -139,7 +140,8 @@ namespace WUPSConfigAPIBackend {
         if (openedCallback == nullptr || closedCallback == nullptr) {
             return WUPSCONFIG_API_RESULT_INVALID_ARGUMENT;
         }
-        for (auto &cur : gLoadedPlugins) {
+        PluginRegistry::ReadGuard registry;
+        for (const auto &cur : registry->plugins) {
             if (cur.getHandle() == pluginIdentifier) {
                 if (options.version != 1) {
                     return WUPSCONFIG_API_RESULT_UNSUPPORTED_VERSION;
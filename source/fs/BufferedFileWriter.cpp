@@ -0,0 +1,45 @@
+#include "BufferedFileWriter.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cstring>
+#include <malloc.h>
+
+BufferedFileWriter::BufferedFileWriter(CFile &file) : mFile(file) {
+    // Aligned, so the file system can use the buffer directly.
+    mBuffer = (uint8_t *) memalign(0x40, BUFFER_SIZE);
+    if (!mBuffer) {
+        DEBUG_FUNCTION_LINE_ERR("Failed to allocate write buffer");
+        mFailed = true;
+    }
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+    free(mBuffer);
+}
+
+bool BufferedFileWriter::write(const void *data, size_t size) {
+    auto *src = (const uint8_t *) data;
+    while (size > 0 && !mFailed) {
+        if (mUsed == BUFFER_SIZE && !flush()) {
+            break;
+        }
+        size_t chunk = std::min(size, BUFFER_SIZE - mUsed);
+        memcpy(mBuffer + mUsed, src, chunk);
+        mUsed += chunk;
+        src += chunk;
+        size -= chunk;
+    }
+    return !mFailed;
+}
+
+bool BufferedFileWriter::flush() {
+    if (mFailed) {
+        return false;
+    }
+    if (mUsed > 0 && mFile.write(mBuffer, mUsed) != (int32_t) mUsed) {
+        mFailed = true;
+        return false;
+    }
+    mUsed = 0;
+    return true;
+}
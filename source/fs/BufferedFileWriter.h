@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CFile.hpp"
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Collects small writes in a fixed size buffer and only writes full buffers to the file,
+ * so data can be streamed to the SD card without building it in memory first.
+ * After a failed write all further writes are ignored, check hasFailed() before closing the file.
+ */
+class BufferedFileWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 0x1000;
+
+    explicit BufferedFileWriter(CFile &file);
+
+    BufferedFileWriter(const BufferedFileWriter &) = delete;
+
+    ~BufferedFileWriter();
+
+    bool write(const void *data, size_t size);
+
+    bool write(std::string_view str) {
+        return write(str.data(), str.size());
+    }
+
+    bool put(char c) {
+        if (mUsed == BUFFER_SIZE && !flush()) {
+            return false;
+        }
+        if (mFailed) {
+            return false;
+        }
+        mBuffer[mUsed++] = c;
+        return true;
+    }
+
+    /**
+     * Writes the buffered data to the file.
+     */
+    bool flush();
+
+    [[nodiscard]] bool hasFailed() const {
+        return mFailed;
+    }
+
+private:
+    CFile &mFile;
+    uint8_t *mBuffer = nullptr;
+    size_t mUsed     = 0;
+    bool mFailed     = false;
+};
@@ -1,10 +1,12 @@
 #include "fs/FSUtils.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
 #include <fcntl.h>
 #include <filesystem>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <vector>
 
@@ -59,3 +61,14 @@ bool FSUtils::CreateSubfolder(std::string_view fullpath) {
     }
     return true;
 }
+
+bool FSUtils::ReplaceFile(std::string_view source, std::string_view target) {
+    if (rename(source.data(), target.data()) == 0) {
+        return true;
+    }
+    // Not every devoptab can rename onto an existing file.
+    if (remove(target.data()) != 0 && errno != ENOENT) {
+        return false;
+    }
+    return rename(source.data(), target.data()) == 0;
+}
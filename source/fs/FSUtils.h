@@ -9,4 +9,9 @@ public:
     static int32_t LoadFileToMem(std::string_view filepath, std::vector<uint8_t> &buffer);
 
     static bool CreateSubfolder(std::string_view fullpath);
+
+    /**
+     * Moves source to target, an existing target is replaced.
+     */
+    static bool ReplaceFile(std::string_view source, std::string_view target);
 };
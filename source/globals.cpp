@@ -16,4 +16,10 @@ bool gNotificationModuleLoaded = false;
 
 OSThread *gOnlyAcceptFromThread = nullptr;
 
-bool gConfigMenuShouldClose = false;
\ No newline at end of file
+bool gConfigMenuShouldClose = false;
+
+std::atomic<uint32_t> gHookTimeBudgetInMicroseconds      = 0;
+std::atomic<uint32_t> gFrameCallbackBudgetInMicroseconds = 0;
+
+OSTime gApplicationStartTime         = 0;
+std::atomic<bool> gFirstFramePending = false;
\ No newline at end of file
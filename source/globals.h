@@ -3,6 +3,8 @@
 #include "utils/config/ConfigUtils.h"
 #include "version.h"
 #include <coreinit/dynload.h>
+#include <coreinit/time.h>
+#include <atomic>
 #include <forward_list>
 #include <memory>
 #include <mutex>
@@ -29,4 +31,15 @@ extern bool gNotificationModuleLoaded;
 
 extern OSThread *gOnlyAcceptFromThread;
 
-extern bool gConfigMenuShouldClose;
\ No newline at end of file
+extern bool gConfigMenuShouldClose;
+
+// Log a warning if a single hook call of a plugin takes longer than this. 0 disables the warning.
+extern std::atomic<uint32_t> gHookTimeBudgetInMicroseconds;
+// Log a warning if the frame callbacks of all plugins combined take longer than this. 0 disables the warning.
+extern std::atomic<uint32_t> gFrameCallbackBudgetInMicroseconds;
+
+// Set when WUMS_APPLICATION_STARTS begins.
+extern OSTime gApplicationStartTime;
+// Set after gApplicationStartTime has been written, reset by the first frame once it has been reported.
+// 64 bit atomics are not lock-free on the Wii U, so the start time itself is not atomic.
+extern std::atomic<bool> gFirstFramePending;
\ No newline at end of file
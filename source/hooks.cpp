@@ -1,8 +1,12 @@
 #include "hooks.h"
+#include "globals.h"
+#include "plugin/HookDispatchTable.h"
 #include "plugin/PluginContainer.h"
 #include "utils/StorageUtilsDeprecated.h"
+#include "utils/ConcurrentTaskRunner.h"
 #include "utils/logger.h"
 #include "utils/storage/StorageUtils.h"
+#include <coreinit/time.h>
 #include <wups/storage.h>
 
 static const char **hook_names = (const char *[]){
@@ -35,99 +39,138 @@ static const char **hook_names = (const char *[]){
         "WUPS_LOADER_HOOK_INIT_STORAGE",
         "WUPS_LOADER_HOOK_INIT_CONFIG"};
 
-void CallHook(const std::vector<PluginContainer> &plugins, wups_loader_hook_type_t hook_type) {
-    DEBUG_FUNCTION_LINE_VERBOSE("Calling hook of type %s [%d]", hook_names[hook_type], hook_type);
-    for (const auto &plugin : plugins) {
-        CallHook(plugin, hook_type);
+namespace {
+    void CallInitStorageHook(const PluginContainer &plugin, void *func_ptr) {
+        if (plugin.getMetaInformation().getWUPSVersion() <= WUPSVersion(0, 7, 1)) {
+            WUPSStorageDeprecated::wups_loader_init_storage_args_t_ args{};
+            args.open_storage_ptr  = &WUPSStorageDeprecated::StorageUtils::OpenStorage;
+            args.close_storage_ptr = &WUPSStorageDeprecated::StorageUtils::CloseStorage;
+            args.plugin_id         = plugin.getMetaInformation().getStorageId().c_str();
+            // clang-format off
+
+            ((void(*)(WUPSStorageDeprecated::wups_loader_init_storage_args_t_))((uint32_t *) func_ptr))(args);
+            // clang-format on
+            return;
+        }
+        wups_loader_init_storage_args_t_ args{};
+        args.version                      = WUPS_STORAGE_CUR_API_VERSION;
+        args.root_item                    = plugin.getStorageRootItem();
+        args.save_function_ptr            = &StorageUtils::API::SaveStorage;
+        args.force_reload_function_ptr    = &StorageUtils::API::ForceReloadStorage;
+        args.wipe_storage_function_ptr    = &StorageUtils::API::WipeStorage;
+        args.delete_item_function_ptr     = &StorageUtils::API::DeleteItem;
+        args.create_sub_item_function_ptr = &StorageUtils::API::CreateSubItem;
+        args.get_sub_item_function_ptr    = &StorageUtils::API::GetSubItem;
+        args.store_item_function_ptr      = &StorageUtils::API::StoreItem;
+        args.get_item_function_ptr        = &StorageUtils::API::GetItem;
+        args.get_item_size_function_ptr   = &StorageUtils::API::GetItemSize;
+        // clang-format off
+        auto res = ((WUPSStorageError(*)(wups_loader_init_storage_args_t_))((uint32_t *) func_ptr))(args);
+        // clang-format on
+        if (res != WUPS_STORAGE_ERROR_SUCCESS) {
+            // TODO: More error handling? Notification?
+            DEBUG_FUNCTION_LINE_ERR("WUPS_LOADER_HOOK_INIT_STORAGE failed for plugin %s: %s", plugin.getMetaInformation().getName().c_str(), WUPSStorageAPI_GetStatusStr(res));
+        }
     }
-}
 
-void CallHook(const PluginContainer &plugin, wups_loader_hook_type_t hook_type) {
-    for (const auto &hook : plugin.getPluginInformation().getHookDataList()) {
-        if (hook.getType() == hook_type) {
-            DEBUG_FUNCTION_LINE_VERBOSE("Calling hook of type %s for plugin %s [%d]", hook_names[hook.getType()], plugin.getMetaInformation().getName().c_str(), hook_type);
-            void *func_ptr = hook.getFunctionPointer();
-            if (func_ptr != nullptr) {
-                switch (hook_type) {
-                    case WUPS_LOADER_HOOK_INIT_WUT_MALLOC:
-                    case WUPS_LOADER_HOOK_FINI_WUT_MALLOC:
-                    case WUPS_LOADER_HOOK_INIT_WUT_NEWLIB:
-                    case WUPS_LOADER_HOOK_FINI_WUT_NEWLIB:
-                    case WUPS_LOADER_HOOK_INIT_WUT_STDCPP:
-                    case WUPS_LOADER_HOOK_FINI_WUT_STDCPP:
-                    case WUPS_LOADER_HOOK_INIT_WUT_DEVOPTAB:
-                    case WUPS_LOADER_HOOK_FINI_WUT_DEVOPTAB:
-                    case WUPS_LOADER_HOOK_INIT_WUT_SOCKETS:
-                    case WUPS_LOADER_HOOK_FINI_WUT_SOCKETS:
-                    case WUPS_LOADER_HOOK_INIT_WRAPPER:
-                    case WUPS_LOADER_HOOK_FINI_WRAPPER:
-                    case WUPS_LOADER_HOOK_GET_CONFIG_DEPRECATED:
-                    case WUPS_LOADER_HOOK_CONFIG_CLOSED_DEPRECATED:
-                    case WUPS_LOADER_HOOK_INIT_PLUGIN:
-                    case WUPS_LOADER_HOOK_DEINIT_PLUGIN:
-                    case WUPS_LOADER_HOOK_APPLICATION_STARTS:
-                    case WUPS_LOADER_HOOK_RELEASE_FOREGROUND:
-                    case WUPS_LOADER_HOOK_ACQUIRED_FOREGROUND:
-                    case WUPS_LOADER_HOOK_APPLICATION_REQUESTS_EXIT:
-                    case WUPS_LOADER_HOOK_APPLICATION_ENDS:
-                        // clang-format off
-                        ((void(*)())((uint32_t *) func_ptr))();
-                        // clang-format on
-                        break;
-                    case WUPS_LOADER_HOOK_INIT_STORAGE:
-                    case WUPS_LOADER_HOOK_INIT_STORAGE_DEPRECATED: {
-                        if (plugin.getMetaInformation().getWUPSVersion() <= WUPSVersion(0, 7, 1)) {
-                            WUPSStorageDeprecated::wups_loader_init_storage_args_t_ args{};
-                            args.open_storage_ptr  = &WUPSStorageDeprecated::StorageUtils::OpenStorage;
-                            args.close_storage_ptr = &WUPSStorageDeprecated::StorageUtils::CloseStorage;
-                            args.plugin_id         = plugin.getMetaInformation().getStorageId().c_str();
-                            // clang-format off
+    void CallInitConfigHook(const PluginContainer &plugin, void *func_ptr) {
+        wups_loader_init_config_args_t args{.arg_version = 1, .plugin_identifier = plugin.getHandle()};
+        // clang-format off
+        auto res = ((WUPSConfigAPIStatus(*)(wups_loader_init_config_args_t))((uint32_t *) func_ptr))(args);
+        // clang-format on
+        if (res != WUPSCONFIG_API_RESULT_SUCCESS) {
+            // TODO: More error handling? Notification?
+            DEBUG_FUNCTION_LINE_ERR("WUPS_LOADER_HOOK_INIT_CONFIG failed for plugin %s: %s", plugin.getMetaInformation().getName().c_str(), WUPSConfigAPI_GetStatusStr(res));
+        }
+    }
+    void CallVoidHook(const HookDispatchEntry &entry) {
+        // clang-format off
+        ((void(*)())((uint32_t *) entry.functionPointer))();
+        // clang-format on
+    }
 
-                            ((void(*)(WUPSStorageDeprecated::wups_loader_init_storage_args_t_))((uint32_t *) func_ptr))(args);
-                            // clang-format on
-                            break;
-                        }
-                        wups_loader_init_storage_args_t_ args{};
-                        args.version                      = WUPS_STORAGE_CUR_API_VERSION;
-                        args.root_item                    = plugin.getStorageRootItem();
-                        args.save_function_ptr            = &StorageUtils::API::SaveStorage;
-                        args.force_reload_function_ptr    = &StorageUtils::API::ForceReloadStorage;
-                        args.wipe_storage_function_ptr    = &StorageUtils::API::WipeStorage;
-                        args.delete_item_function_ptr     = &StorageUtils::API::DeleteItem;
-                        args.create_sub_item_function_ptr = &StorageUtils::API::CreateSubItem;
-                        args.get_sub_item_function_ptr    = &StorageUtils::API::GetSubItem;
-                        args.store_item_function_ptr      = &StorageUtils::API::StoreItem;
-                        args.get_item_function_ptr        = &StorageUtils::API::GetItem;
-                        args.get_item_size_function_ptr   = &StorageUtils::API::GetItemSize;
-                        // clang-format off
-                        auto res = ((WUPSStorageError(*)(wups_loader_init_storage_args_t_))((uint32_t *) func_ptr))(args);
-                        // clang-format on
-                        if (res != WUPS_STORAGE_ERROR_SUCCESS) {
-                            // TODO: More error handling? Notification?
-                            DEBUG_FUNCTION_LINE_ERR("WUPS_LOADER_HOOK_INIT_STORAGE failed for plugin %s: %s", plugin.getMetaInformation().getName().c_str(), WUPSStorageAPI_GetStatusStr(res));
-                        }
-                        break;
-                    }
-                    case WUPS_LOADER_HOOK_INIT_CONFIG: {
-                        wups_loader_init_config_args_t args{.arg_version = 1, .plugin_identifier = plugin.getHandle()};
-                        auto res = ((WUPSConfigAPIStatus(*)(wups_loader_init_config_args_t))((uint32_t *) func_ptr))(args);
-                        // clang-format on
-                        if (res != WUPSCONFIG_API_RESULT_SUCCESS) {
-                            // TODO: More error handling? Notification?
-                            DEBUG_FUNCTION_LINE_ERR("WUPS_LOADER_HOOK_INIT_CONFIG failed for plugin %s: %s", plugin.getMetaInformation().getName().c_str(), WUPSConfigAPI_GetStatusStr(res));
-                        }
-                        break;
-                    }
-                    default: {
-                        DEBUG_FUNCTION_LINE_ERR("######################################");
-                        DEBUG_FUNCTION_LINE_ERR("Hook is not implemented %s [%d]", hook_names[hook_type], hook_type);
-                        DEBUG_FUNCTION_LINE_ERR("######################################");
-                    }
-                }
-            } else {
-                DEBUG_FUNCTION_LINE_ERR("Failed to call hook. It was not defined");
+    template<typename Fn>
+    void CallHookEntry(const HookDispatchEntry &entry, wups_loader_hook_type_t hook_type, Fn &&call) {
+        if (entry.functionPointer == nullptr) {
+            DEBUG_FUNCTION_LINE_ERR("Failed to call hook. It was not defined");
+            return;
+        }
+        DEBUG_FUNCTION_LINE_VERBOSE("Calling hook of type %s for plugin %s [%d]", hook_names[hook_type], entry.plugin->getMetaInformation().getName().c_str(), hook_type);
+        auto startTime = OSGetSystemTime();
+        call(entry);
+        auto duration   = OSGetSystemTime() - startTime;
+        uint32_t budget = gHookTimeBudgetInMicroseconds;
+        bool overBudget = budget != 0 && OSTicksToMicroseconds(duration) > budget;
+        auto stats      = entry.plugin->addHookDuration(hook_type, duration, overBudget);
+        // Don't flood the log if a hook exceeds the budget on every call, only the first overrun is logged, all others are counted.
+        if (overBudget && stats.overBudgetCount == 1) {
+            DEBUG_FUNCTION_LINE_WARN("%s of plugin %s took %lld us (budget: %d us)", hook_names[hook_type], entry.plugin->getMetaInformation().getName().c_str(), OSTicksToMicroseconds(duration), budget);
+        }
+    }
+
+    /**
+     * Hooks of plugins that opted in via "concurrent_hooks=true" are called on worker threads, while the hooks of all other
+     * plugins are called one after another in the usual order on the current thread. Returns after all hooks have been called.
+     */
+    void CallVoidHooksConcurrently(std::span<const HookDispatchEntry> entries, wups_loader_hook_type_t hook_type) {
+        std::vector<const HookDispatchEntry *> concurrentEntries;
+        for (const auto &entry : entries) {
+            if (entry.plugin->getMetaInformation().allowsConcurrentHooks()) {
+                concurrentEntries.push_back(&entry);
+            }
+        }
+
+        ConcurrentTaskRunner runner([&concurrentEntries, hook_type](uint32_t index) { CallHookEntry(*concurrentEntries[index], hook_type, CallVoidHook); },
+                                    concurrentEntries.size());
+        runner.start();
+        for (const auto &entry : entries) {
+            if (!entry.plugin->getMetaInformation().allowsConcurrentHooks()) {
+                CallHookEntry(entry, hook_type, CallVoidHook);
             }
-            break;
         }
+        runner.join();
     }
+} // namespace
+
+void CallHook(const HookDispatchTable &table, wups_loader_hook_type_t hook_type) {
+    if ((uint32_t) hook_type >= WUPS_LOADER_HOOK_TYPE_COUNT) {
+        DEBUG_FUNCTION_LINE_ERR("######################################");
+        DEBUG_FUNCTION_LINE_ERR("Hook is not implemented [%d]", hook_type);
+        DEBUG_FUNCTION_LINE_ERR("######################################");
+        return;
+    }
+    DEBUG_FUNCTION_LINE_VERBOSE("Calling hook of type %s [%d]", hook_names[hook_type], hook_type);
+
+    // Resolve the calling convention once, not for every plugin.
+    const auto entries = table.getEntries(hook_type);
+    switch (hook_type) {
+        case WUPS_LOADER_HOOK_INIT_STORAGE:
+        case WUPS_LOADER_HOOK_INIT_STORAGE_DEPRECATED:
+            for (const auto &entry : entries) {
+                CallHookEntry(entry, hook_type, [](const HookDispatchEntry &entry) { CallInitStorageHook(*entry.plugin, entry.functionPointer); });
+            }
+            break;
+        case WUPS_LOADER_HOOK_INIT_CONFIG:
+            for (const auto &entry : entries) {
+                CallHookEntry(entry, hook_type, [](const HookDispatchEntry &entry) { CallInitConfigHook(*entry.plugin, entry.functionPointer); });
+            }
+            break;
+        case WUPS_LOADER_HOOK_INIT_PLUGIN:
+        case WUPS_LOADER_HOOK_APPLICATION_STARTS:
+            CallVoidHooksConcurrently(entries, hook_type);
+            break;
+        default:
+            for (const auto &entry : entries) {
+                CallHookEntry(entry, hook_type, CallVoidHook);
+            }
+            break;
+    }
+}
+
+void CallHook(std::span<const PluginContainer> plugins, wups_loader_hook_type_t hook_type) {
+    CallHook(HookDispatchTable(plugins), hook_type);
+}
+
+void CallHook(const PluginContainer &plugin, wups_loader_hook_type_t hook_type) {
+    CallHook(std::span(&plugin, 1), hook_type);
 }
\ No newline at end of file
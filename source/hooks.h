@@ -1,10 +1,18 @@
 #pragma once
 
+#include "plugin/HookDispatchTable.h"
 #include "plugin/PluginContainer.h"
 #include <memory>
+#include <span>
 #include <vector>
 #include <wups/hooks.h>
 
-void CallHook(const std::vector<PluginContainer> &plugins, wups_loader_hook_type_t hook_type);
+/**
+ * Calls the given hook of all plugins in the table. Prefer this over the other overloads when calling hooks repeatedly,
+ * the other overloads build a temporary table on each call.
+ */
+void CallHook(const HookDispatchTable &table, wups_loader_hook_type_t hook_type);
+
+void CallHook(std::span<const PluginContainer> plugins, wups_loader_hook_type_t hook_type);
 
 void CallHook(const PluginContainer &plugin, wups_loader_hook_type_t hook_type);
\ No newline at end of file
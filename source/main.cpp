@@ -4,9 +4,19 @@
 #include "globals.h"
 #include "hooks.h"
 #include "patcher/hooks_patcher_static.h"
-#include "plugin/PluginDataFactory.h"
+#include "plugin/AsyncPluginDataLoader.h"
+#include "plugin/PluginPreparation.h"
+#include "plugin/PluginRegistry.h"
+#include "utils/FrameCallbacks.h"
+#include "utils/InputSubscribers.h"
+#include "utils/PatchChainUtils.h"
+#include "utils/TaskRuntime.h"
+#include "utils/storage/StorageUtils.h"
 #include "utils/utils.h"
+#include <algorithm>
+#include <array>
 #include <coreinit/debug.h>
+#include <coreinit/title.h>
 #include <notifications/notifications.h>
 #include <wums.h>
 
@@ -46,7 +56,8 @@ WUMS_APPLICATION_REQUESTS_EXIT() {
     if (upid != 2 && upid != 15) {
         return;
     }
-    CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_APPLICATION_REQUESTS_EXIT);
+    PluginRegistry::ReadGuard registry;
+    CallHook(registry->hooks, WUPS_LOADER_HOOK_APPLICATION_REQUESTS_EXIT);
 }
 
 WUMS_APPLICATION_ENDS() {
@@ -55,19 +66,31 @@ WUMS_APPLICATION_ENDS() {
         return;
     }
 
-    CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_APPLICATION_ENDS);
-    CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_FINI_WUT_SOCKETS);
-    CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_FINI_WUT_DEVOPTAB);
+    {
+        PluginRegistry::ReadGuard registry;
+        CallHook(registry->hooks, WUPS_LOADER_HOOK_APPLICATION_ENDS);
+        CallHook(registry->hooks, WUPS_LOADER_HOOK_FINI_WUT_SOCKETS);
+        CallHook(registry->hooks, WUPS_LOADER_HOOK_FINI_WUT_DEVOPTAB);
+    }
 
     for (const auto &pair : gUsedRPLs) {
         OSDynLoad_Release(pair.second);
     }
     gUsedRPLs.clear();
 
+    // The plugins for the next launch are prepared on a worker of the task runtime, which is stopped below.
+    PluginPreparation::WaitUntilDone();
+
+    // Storages are written on the I/O thread of the task runtime.
+    StorageUtils::API::Internal::FlushStorage();
+
+    // Worker threads must not outlive the application.
+    TaskRuntime::Shutdown();
+
     deinitLogging();
 }
 
-void CheckCleanupCallbackUsage(const std::vector<PluginContainer> &plugins);
+void CheckCleanupCallbackUsage(std::span<const PluginContainer> plugins);
 
 WUMS_APPLICATION_STARTS() {
     uint32_t upid = OSGetUPID();
@@ -75,6 +98,9 @@ WUMS_APPLICATION_STARTS() {
         return;
     }
 
+    gApplicationStartTime = OSGetSystemTime();
+    gFirstFramePending    = true;
+
     OSReport("Running WiiUPluginLoaderBackend " VERSION_FULL "\n");
     gStoredTVBuffer = {};
 
@@ -89,8 +115,10 @@ WUMS_APPLICATION_STARTS() {
     gAllocatedAddresses.clear();
 
     initLogging();
-    bool initNeeded = false;
 
+    TaskRuntime::Start();
+
+    PluginPreparation::WaitUntilDone();
     std::lock_guard<std::mutex> lock(gLoadedDataMutex);
 
     if (gTrampData.empty()) {
@@ -100,56 +128,116 @@ WUMS_APPLICATION_STARTS() {
         }
     }
 
+    // Readers must not see the plugins while they are moved around.
+    PluginRegistry::Clear();
+
     if (gLoadedPlugins.empty()) {
         auto pluginPath = getPluginPath();
 
         DEBUG_FUNCTION_LINE("Load plugins from %s", pluginPath.c_str());
 
-        auto pluginData = PluginDataFactory::loadDir(pluginPath);
-        gLoadedPlugins  = PluginManagement::loadPlugins(pluginData, gTrampData);
-
-        initNeeded = true;
+        // Read the plugins from the SD card on another core while linking the ones that have already been read.
+        AsyncPluginDataLoader loader(pluginPath);
+        loader.start();
+        while (auto pluginData = loader.next()) {
+            auto plugins = PluginManagement::loadPlugins({pluginData}, gTrampData, gLoadedPlugins);
+            for (auto &plugin : plugins) {
+                gLoadedPlugins.push_back(std::move(plugin));
+            }
+        }
     }
 
     if (!gLoadOnNextLaunch.empty()) {
-        auto *currentThread        = OSGetCurrentThread();
-        auto saved_reent           = currentThread->reserved[4];
-        auto saved_cleanupCallback = currentThread->cleanupCallback;
+        std::vector<PluginContainer> pluginsToKeep;
+        std::vector<PluginContainer> pluginsToUnload;
+        std::set<std::shared_ptr<PluginData>> pluginDataToLoad;
+        PluginManagement::diffPlugins(std::move(gLoadedPlugins), gLoadOnNextLaunch, pluginsToKeep, pluginsToUnload, pluginDataToLoad);
+        DEBUG_FUNCTION_LINE("Keep %d plugins, unload %d plugins, load %d plugins", pluginsToKeep.size(), pluginsToUnload.size(), pluginDataToLoad.size());
 
-        currentThread->reserved[4] = 0;
+        if (!pluginsToUnload.empty()) {
+            auto *currentThread        = OSGetCurrentThread();
+            auto saved_reent           = currentThread->reserved[4];
+            auto saved_cleanupCallback = currentThread->cleanupCallback;
 
-        CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_DEINIT_PLUGIN);
+            currentThread->reserved[4] = 0;
 
-        CheckCleanupCallbackUsage(gLoadedPlugins);
+            CallHook(HookDispatchTable(pluginsToUnload, [](const PluginContainer &plugin) { return plugin.isInitialized(); }), WUPS_LOADER_HOOK_DEINIT_PLUGIN);
 
-        if (currentThread->cleanupCallback != saved_cleanupCallback) {
-            DEBUG_FUNCTION_LINE_WARN("WUPS_LOADER_HOOK_DEINIT_PLUGIN overwrote the ThreadCleanupCallback, we need to restore it!\n");
-            OSSetThreadCleanupCallback(OSGetCurrentThread(), saved_cleanupCallback);
-        }
+            CheckCleanupCallbackUsage(pluginsToUnload);
+
+            if (currentThread->cleanupCallback != saved_cleanupCallback) {
+                DEBUG_FUNCTION_LINE_WARN("WUPS_LOADER_HOOK_DEINIT_PLUGIN overwrote the ThreadCleanupCallback, we need to restore it!\n");
+                OSSetThreadCleanupCallback(OSGetCurrentThread(), saved_cleanupCallback);
+            }
 
-        currentThread->reserved[4] = saved_reent;
+            currentThread->reserved[4] = saved_reent;
 
-        DEBUG_FUNCTION_LINE("Restore function patches of currently loaded plugins.");
-        PluginManagement::RestoreFunctionPatches(gLoadedPlugins);
+            DEBUG_FUNCTION_LINE("Restore function patches of plugins that will be unloaded.");
+            PluginManagement::RestoreFunctionPatches(pluginsToUnload);
+            InputSubscribers::RemoveSubscribersOfPlugins(pluginsToUnload);
+            FrameCallbacks::RemoveCallbacksOfPlugins(pluginsToUnload);
 
-        for (auto &plugin : gLoadedPlugins) {
-            WUPSStorageError err = plugin.CloseStorage();
-            if (err != WUPS_STORAGE_ERROR_SUCCESS) {
-                DEBUG_FUNCTION_LINE_ERR("Failed to close storage for plugin: %s", plugin.getMetaInformation().getName().c_str());
+            for (auto &plugin : pluginsToUnload) {
+                WUPSStorageError err = plugin.CloseStorage();
+                if (err != WUPS_STORAGE_ERROR_SUCCESS) {
+                    DEBUG_FUNCTION_LINE_ERR("Failed to close storage for plugin: %s", plugin.getMetaInformation().getName().c_str());
+                }
             }
+
+            DEBUG_FUNCTION_LINE("Unload removed plugins.");
+            PluginManagement::freeTrampolines(pluginsToUnload, gTrampData);
+            pluginsToUnload.clear();
         }
 
-        DEBUG_FUNCTION_LINE("Unload existing plugins.");
-        gLoadedPlugins.clear();
-        for (auto &cur : gTrampData) {
-            cur.status = RELOC_TRAMP_FREE;
+        gLoadedPlugins = std::move(pluginsToKeep);
+
+        std::vector<PluginContainer> preparedPlugins;
+        PluginPreparation::TakePrepared(pluginDataToLoad, preparedPlugins);
+        if (!preparedPlugins.empty()) {
+            DEBUG_FUNCTION_LINE("Patch %d prepared plugins", preparedPlugins.size());
+            if (!PluginManagement::DoFunctionPatches(preparedPlugins)) {
+                DEBUG_FUNCTION_LINE_ERR("Failed to patch functions");
+                OSFatal("WiiUPluginLoaderBackend: Failed to patch functions");
+            }
+            for (auto &plugin : preparedPlugins) {
+                gLoadedPlugins.push_back(std::move(plugin));
+            }
         }
 
-        DEBUG_FUNCTION_LINE("Load new plugins");
-        gLoadedPlugins = PluginManagement::loadPlugins(gLoadOnNextLaunch, gTrampData);
-        initNeeded     = true;
+        if (!pluginDataToLoad.empty()) {
+            DEBUG_FUNCTION_LINE("Load new plugins");
+            auto newPlugins = PluginManagement::loadPlugins(pluginDataToLoad, gTrampData, gLoadedPlugins);
+            gLoadedPlugins.reserve(gLoadedPlugins.size() + newPlugins.size());
+            for (auto &plugin : newPlugins) {
+                gLoadedPlugins.push_back(std::move(plugin));
+            }
+        }
     }
 
+    PluginManagement::updateActivation(gLoadedPlugins, OSGetTitleID());
+    InputSubscribers::UpdateActivation(gLoadedPlugins);
+    FrameCallbacks::UpdateActivation(gLoadedPlugins);
+
+    // Plugins are initialized the first time they are active.
+    const auto needsInit = [](const PluginContainer &plugin) { return plugin.isActive() && !plugin.isInitialized(); };
+    auto pluginsToInit   = HookDispatchTable(gLoadedPlugins, needsInit);
+    // The plugins must not be modified once they are published, so this is done before their init hooks are called.
+    for (auto &plugin : gLoadedPlugins) {
+        if (!needsInit(plugin)) {
+            continue;
+        }
+        WUPSStorageError err = plugin.OpenStorage();
+        if (err != WUPS_STORAGE_ERROR_SUCCESS) {
+            DEBUG_FUNCTION_LINE_ERR("Failed to open storage for plugin: %s. (%s)", plugin.getMetaInformation().getName().c_str(), WUPSStorageAPI_GetStatusStr(err));
+        }
+        plugin.setInitialized();
+    }
+    PluginRegistry::Publish(gLoadedPlugins);
+
+#ifdef DEBUG
+    PatchChainUtils::logPatchChains(PatchChainUtils::buildPatchChains(gLoadedPlugins));
+#endif
+
     DEBUG_FUNCTION_LINE("Clear plugin data lists.");
     gLoadOnNextLaunch.clear();
     gLoadedData.clear();
@@ -161,55 +249,79 @@ WUMS_APPLICATION_STARTS() {
         }
         // PluginManagement::memsetBSS(plugins);
 
-        if (initNeeded) {
-            CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_INIT_WUT_MALLOC);
-            CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_INIT_WUT_NEWLIB);
-            CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_INIT_WUT_STDCPP);
-        }
-        CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_INIT_WUT_DEVOPTAB);
-        CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_INIT_WUT_SOCKETS);
+        PluginRegistry::ReadGuard registry;
 
-        if (initNeeded) {
-            CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_INIT_WRAPPER);
-        }
+        CallHook(pluginsToInit, WUPS_LOADER_HOOK_INIT_WUT_MALLOC);
+        CallHook(pluginsToInit, WUPS_LOADER_HOOK_INIT_WUT_NEWLIB);
+        CallHook(pluginsToInit, WUPS_LOADER_HOOK_INIT_WUT_STDCPP);
 
-        if (initNeeded) {
-            for (auto &plugin : gLoadedPlugins) {
-                WUPSStorageError err = plugin.OpenStorage();
-                if (err != WUPS_STORAGE_ERROR_SUCCESS) {
-                    DEBUG_FUNCTION_LINE_ERR("Failed to open storage for plugin: %s. (%s)", plugin.getMetaInformation().getName().c_str(), WUPSStorageAPI_GetStatusStr(err));
-                }
-            }
-            PluginManagement::callInitHooks(gLoadedPlugins);
-        }
+        CallHook(registry->hooks, WUPS_LOADER_HOOK_INIT_WUT_DEVOPTAB);
+        CallHook(registry->hooks, WUPS_LOADER_HOOK_INIT_WUT_SOCKETS);
+
+        CallHook(pluginsToInit, WUPS_LOADER_HOOK_INIT_WRAPPER);
 
-        CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_APPLICATION_STARTS);
+        PluginManagement::callInitHooks(pluginsToInit);
+
+        CallHook(registry->hooks, WUPS_LOADER_HOOK_APPLICATION_STARTS);
     }
+
+    DEBUG_FUNCTION_LINE("Application start took %lld ms", OSTicksToMilliseconds(OSGetSystemTime() - gApplicationStartTime));
 }
 
-void CheckCleanupCallbackUsage(const std::vector<PluginContainer> &plugins) {
-    auto *curThread = OSGetCurrentThread();
+void CheckCleanupCallbackUsage(std::span<const PluginContainer> plugins) {
+    struct TextRange {
+        uint32_t start;
+        uint32_t end;
+        const PluginContainer *plugin;
+    };
+    // Sorted by start address, so each cleanupCallback can be looked up with a binary search.
+    std::vector<TextRange> ranges;
+    ranges.reserve(plugins.size());
     for (const auto &cur : plugins) {
         auto textSection = cur.getPluginInformation().getSectionInfo(".text");
         if (!textSection) {
             continue;
         }
-        uint32_t startAddress = textSection->getAddress();
-        uint32_t endAddress   = textSection->getAddress() + textSection->getSize();
-        auto *pluginName      = cur.getMetaInformation().getName().c_str();
-        {
-            __OSLockScheduler(curThread);
-            int state   = OSDisableInterrupts();
-            OSThread *t = *((OSThread **) 0x100567F8);
-            while (t) {
-                auto address = reinterpret_cast<uint32_t>(t->cleanupCallback);
-                if (address != 0 && address >= startAddress && address <= endAddress) {
-                    OSReport("[WARN] PluginBackend: Thread 0x%08X is using a function from plugin %s for the threadCleanupCallback\n", t, pluginName);
+        ranges.push_back({.start = textSection->getAddress(), .end = textSection->getAddress() + textSection->getSize(), .plugin = &cur});
+    }
+    if (ranges.empty()) {
+        return;
+    }
+    std::ranges::sort(ranges, {}, &TextRange::start);
+
+    struct Match {
+        OSThread *thread;
+        const PluginContainer *plugin;
+    };
+    // Matches are only reported after the interrupts have been restored.
+    std::array<Match, 16> matches{};
+    uint32_t numberOfMatches = 0;
+
+    auto *curThread = OSGetCurrentThread();
+    __OSLockScheduler(curThread);
+    int state   = OSDisableInterrupts();
+    OSThread *t = *((OSThread **) 0x100567F8);
+    while (t) {
+        auto address = reinterpret_cast<uint32_t>(t->cleanupCallback);
+        if (address != 0) {
+            // Find the last range that starts at or before the address.
+            auto it = std::ranges::upper_bound(ranges, address, {}, &TextRange::start);
+            if (it != ranges.begin() && address <= (--it)->end) {
+                if (numberOfMatches < matches.size()) {
+                    matches[numberOfMatches] = {.thread = t, .plugin = it->plugin};
                 }
-                t = t->activeLink.next;
+                numberOfMatches++;
             }
-            OSRestoreInterrupts(state);
-            __OSUnlockScheduler(curThread);
         }
+        t = t->activeLink.next;
+    }
+    OSRestoreInterrupts(state);
+    __OSUnlockScheduler(curThread);
+
+    for (uint32_t i = 0; i < numberOfMatches && i < matches.size(); i++) {
+        OSReport("[WARN] PluginBackend: Thread 0x%08X is using a function from plugin %s for the threadCleanupCallback\n", matches[i].thread, matches[i].plugin->getMetaInformation().getName().c_str());
+    }
+    if (numberOfMatches > matches.size()) {
+        OSReport("[WARN] PluginBackend: %d more threads are using a function from a plugin for the threadCleanupCallback\n", numberOfMatches - matches.size());
     }
 }
@@ -1,19 +1,46 @@
 #include "hooks_patcher_static.h"
 #include <coreinit/core.h>
 #include <coreinit/messagequeue.h>
+#include <coreinit/time.h>
 #include <padscore/wpad.h>
 #include <vpad/input.h>
 
 #include "../globals.h"
 #include "../hooks.h"
+#include "../plugin/PluginRegistry.h"
+#include "../utils/FrameCallbacks.h"
+#include "../utils/InputSubscribers.h"
 
-static uint8_t sVpadPressCooldown  = 0xFF;
-static bool sConfigMenuOpened      = false;
-static bool sWantsToOpenConfigMenu = false;
+static uint8_t sVpadPressCooldown                  = 0xFF;
+static bool sConfigMenuOpened                      = false;
+static bool sWantsToOpenConfigMenu                 = false;
+static uint8_t sFrameCallbackBudgetWarningCooldown = 0;
 
 DECL_FUNCTION(void, GX2SwapScanBuffers, void) {
     real_GX2SwapScanBuffers();
 
+    if (gFirstFramePending.exchange(false)) {
+        DEBUG_FUNCTION_LINE_INFO("Time to first frame: %lld ms", OSTicksToMilliseconds(OSGetSystemTime() - gApplicationStartTime));
+    }
+
+    if (!sConfigMenuOpened) {
+        auto startTime = OSGetSystemTime();
+        FrameCallbacks::Dispatch();
+        auto duration = OSTicksToMicroseconds(OSGetSystemTime() - startTime);
+        // Might be changed by another thread at any time.
+        uint32_t budget = gFrameCallbackBudgetInMicroseconds;
+        if (budget != 0 && duration > budget) {
+            // Don't flood the log if the budget is exceeded every frame.
+            if (sFrameCallbackBudgetWarningCooldown == 0) {
+                DEBUG_FUNCTION_LINE_WARN("Frame callbacks took %lld us (budget: %d us)", duration, budget);
+                sFrameCallbackBudgetWarningCooldown = 0x3C;
+            }
+        }
+        if (sFrameCallbackBudgetWarningCooldown > 0) {
+            sFrameCallbackBudgetWarningCooldown--;
+        }
+    }
+
     if (sWantsToOpenConfigMenu && !sConfigMenuOpened) {
         sConfigMenuOpened = true;
         ConfigUtils::openConfigMenu();
@@ -62,7 +89,8 @@ DECL_FUNCTION(uint32_t, OSReceiveMessage, OSMessageQueue *queue, OSMessage *mess
         if (message != nullptr && res) {
             if (lastData0 != message->args[0]) {
                 if (message->args[0] == 0xFACEF000) {
-                    CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_ACQUIRED_FOREGROUND);
+                    PluginRegistry::ReadGuard registry;
+                    CallHook(registry->hooks, WUPS_LOADER_HOOK_ACQUIRED_FOREGROUND);
                 } else if (message->args[0] == 0xD1E0D1E0) {
                     // Implemented via WUMS Hook
                 }
@@ -75,7 +103,8 @@ DECL_FUNCTION(uint32_t, OSReceiveMessage, OSMessageQueue *queue, OSMessage *mess
 
 DECL_FUNCTION(void, OSReleaseForeground) {
     if (OSGetCoreId() == 1) {
-        CallHook(gLoadedPlugins, WUPS_LOADER_HOOK_RELEASE_FOREGROUND);
+        PluginRegistry::ReadGuard registry;
+        CallHook(registry->hooks, WUPS_LOADER_HOOK_RELEASE_FOREGROUND);
     }
     real_OSReleaseForeground();
 }
@@ -96,6 +125,9 @@ DECL_FUNCTION(int32_t, VPADRead, int32_t chan, VPADStatus *buffer, uint32_t buff
         sVpadPressCooldown     = 0x3C;
         return 0;
     }
+    if (result > 0 && real_error == VPAD_READ_SUCCESS && !sConfigMenuOpened) {
+        InputSubscribers::DispatchVPAD((VPADChan) chan, buffer, std::min((uint32_t) result, buffer_size));
+    }
     if (error) {
         *error = real_error;
     }
@@ -128,6 +160,7 @@ DECL_FUNCTION(void, WPADRead, WPADChan chan, WPADStatusProController *data) {
                 }
             }
         }
+        InputSubscribers::DispatchWPAD(chan, data);
     }
 }
 
@@ -145,7 +178,8 @@ DECL_FUNCTION(uint32_t, SC17_FindClosestSymbol,
               uint32_t symbolNameBufferLength,
               char *moduleNameBuffer,
               uint32_t moduleNameBufferLength) {
-    for (const auto &plugin : gLoadedPlugins) {
+    PluginRegistry::ReadGuard registry;
+    for (const auto &plugin : registry->plugins) {
         const auto sectionInfo = plugin.getPluginInformation().getSectionInfo(".text");
         if (!sectionInfo) {
             continue;
@@ -178,7 +212,8 @@ DECL_FUNCTION(uint32_t, SC17_FindClosestSymbol,
 }
 
 DECL_FUNCTION(uint32_t, KiGetAppSymbolName, uint32_t addr, char *buffer, int32_t bufSize) {
-    for (const auto &plugin : gLoadedPlugins) {
+    PluginRegistry::ReadGuard registry;
+    for (const auto &plugin : registry->plugins) {
         const auto sectionInfo = plugin.getPluginInformation().getSectionInfo(".text");
         if (!sectionInfo) {
             continue;
@@ -0,0 +1,58 @@
+#include "AsyncPluginDataLoader.h"
+#include "PluginDataFactory.h"
+#include "utils/TaskRuntime.h"
+#include "utils/logger.h"
+
+AsyncPluginDataLoader::AsyncPluginDataLoader(std::string path) : mPath(std::move(path)) {
+    OSInitMessageQueue(&mQueue, mMessages.data(), mMessages.size());
+}
+
+AsyncPluginDataLoader::~AsyncPluginDataLoader() {
+    if (mLoadsAsync) {
+        // Drain the queue, otherwise the I/O thread could block forever while sending. The end marker is the last thing the task sends.
+        while (next() != nullptr) {}
+    }
+}
+
+void AsyncPluginDataLoader::start() {
+    // The queue only holds a few plugins, loading them on the calling thread would block forever.
+    if (TaskRuntime::IsRunning() && TaskRuntime::Spawn(loadAll())) {
+        mLoadsAsync = true;
+        return;
+    }
+    DEBUG_FUNCTION_LINE_WARN("TaskRuntime is not running, loading plugins synchronously");
+    // Same order as loading asynchronously, it decides the order of the hooks and patches.
+    PluginDataFactory::loadDir(mPath, [this](std::unique_ptr<PluginData> pluginData) {
+        mSynchronouslyLoaded.push_back(std::move(pluginData));
+    });
+}
+
+std::shared_ptr<PluginData> AsyncPluginDataLoader::next() {
+    if (!mLoadsAsync) {
+        if (mNextSynchronouslyLoaded >= mSynchronouslyLoaded.size()) {
+            return nullptr;
+        }
+        return std::move(mSynchronouslyLoaded[mNextSynchronouslyLoaded++]);
+    }
+    if (mFinished) {
+        return nullptr;
+    }
+    OSMessage message;
+    OSReceiveMessage(&mQueue, &message, OS_MESSAGE_FLAGS_BLOCKING);
+    if (message.message == nullptr) {
+        mFinished = true;
+        return nullptr;
+    }
+    return std::shared_ptr<PluginData>((PluginData *) message.message);
+}
+
+Task<> AsyncPluginDataLoader::loadAll() {
+    co_await TaskRuntime::ScheduleIO();
+    PluginDataFactory::loadDir(mPath, [this](std::unique_ptr<PluginData> pluginData) {
+        OSMessage message = {.message = pluginData.release(), .args = {}};
+        OSSendMessage(&mQueue, &message, OS_MESSAGE_FLAGS_BLOCKING);
+    });
+    // nullptr marks the end
+    OSMessage message = {.message = nullptr, .args = {}};
+    OSSendMessage(&mQueue, &message, OS_MESSAGE_FLAGS_BLOCKING);
+}
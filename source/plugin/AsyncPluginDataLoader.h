@@ -0,0 +1,47 @@
+#pragma once
+
+#include "PluginData.h"
+#include "utils/Task.h"
+#include <array>
+#include <coreinit/messagequeue.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Loads all plugins of a directory into memory on the I/O thread of the TaskRuntime.
+ * The plugins can be taken out one by one while the remaining ones are still being read,
+ * so the SD card access overlaps with parsing and linking the already loaded plugins.
+ */
+class AsyncPluginDataLoader {
+public:
+    explicit AsyncPluginDataLoader(std::string path);
+
+    AsyncPluginDataLoader(const AsyncPluginDataLoader &) = delete;
+
+    ~AsyncPluginDataLoader();
+
+    /**
+     * Starts loading in the background. If the TaskRuntime is not running, the plugins are loaded synchronously.
+     */
+    void start();
+
+    /**
+     * Blocks until the next plugin has been loaded.
+     * @return the next plugin, or nullptr if all plugins have been loaded.
+     */
+    std::shared_ptr<PluginData> next();
+
+private:
+    Task<> loadAll();
+
+    std::string mPath;
+    bool mLoadsAsync = false;
+    OSMessageQueue mQueue{};
+    std::array<OSMessage, 16> mMessages{};
+    bool mFinished = false;
+
+    // Only used if the plugins are loaded synchronously.
+    std::vector<std::shared_ptr<PluginData>> mSynchronouslyLoaded;
+    size_t mNextSynchronouslyLoaded = 0;
+};
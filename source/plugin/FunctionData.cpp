@@ -1,5 +1,10 @@
 #include "FunctionData.h"
 
+namespace {
+    // Patches are only added on the main thread. Starts at 1, 0 means not patched.
+    uint32_t sNextPatchSequence = 1;
+} // namespace
+
 FunctionData::FunctionData(void *paddress, void *vaddress, std::string_view name, function_replacement_library_type_t library, void *replaceAddr, void *replaceCall, FunctionPatcherTargetProcess targetProcess) {
     this->paddress      = paddress;
     this->vaddress      = vaddress;
@@ -45,6 +50,10 @@ FunctionPatcherTargetProcess FunctionData::getTargetProcess() const {
     return targetProcess;
 }
 
+uint32_t FunctionData::getPatchSequence() const {
+    return patchSequence;
+}
+
 bool FunctionData::AddPatch() {
     if (handle == 0) {
         function_replacement_data_t functionData = {
@@ -64,6 +73,7 @@ bool FunctionData::AddPatch() {
             DEBUG_FUNCTION_LINE_ERR("Failed to add patch for function (\"%s\" PA:%08X VA:%08X)", this->name.c_str(), this->paddress, this->vaddress);
             return false;
         }
+        patchSequence = sNextPatchSequence++;
     } else {
         DEBUG_FUNCTION_LINE("Function patch has already been added.");
     }
@@ -76,7 +86,8 @@ bool FunctionData::RemovePatch() {
             DEBUG_FUNCTION_LINE_ERR("Failed to remove patch for function");
             return false;
         }
-        handle = 0;
+        handle        = 0;
+        patchSequence = 0;
     } else {
         DEBUG_FUNCTION_LINE_VERBOSE("Was not patched.");
     }
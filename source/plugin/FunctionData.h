@@ -43,6 +43,12 @@ public:
 
     [[maybe_unused]] [[nodiscard]] FunctionPatcherTargetProcess getTargetProcess() const;
 
+    /**
+     * Increases with every patch that is added to the FunctionPatcher, the patch added last is called first.
+     * 0 if the function is not patched.
+     */
+    [[nodiscard]] uint32_t getPatchSequence() const;
+
     bool AddPatch();
 
     bool RemovePatch();
@@ -57,4 +63,5 @@ private:
     void *replaceCall = nullptr;
 
     PatchedFunctionHandle handle = 0;
+    uint32_t patchSequence       = 0;
 };
@@ -0,0 +1,62 @@
+#include "HookDispatchTable.h"
+#include "PluginContainer.h"
+#include "utils/logger.h"
+
+HookDispatchTable::HookDispatchTable(std::span<const PluginContainer> plugins) : HookDispatchTable(plugins, nullptr) {
+}
+
+HookDispatchTable::HookDispatchTable(std::span<const PluginContainer> plugins, bool (*filter)(const PluginContainer &)) {
+    // Count the hooks per type first, so all entries fit into one contiguous buffer.
+    std::array<uint32_t, WUPS_LOADER_HOOK_TYPE_COUNT> counts{};
+    std::array<const HookData *, WUPS_LOADER_HOOK_TYPE_COUNT> firstHookOfType{};
+    for (const auto &plugin : plugins) {
+        if (filter != nullptr && !filter(plugin)) {
+            continue;
+        }
+        firstHookOfType.fill(nullptr);
+        for (const auto &hook : plugin.getPluginInformation().getHookDataList()) {
+            if ((uint32_t) hook.getType() >= WUPS_LOADER_HOOK_TYPE_COUNT) {
+                DEBUG_FUNCTION_LINE_ERR("Hook is not implemented [%d] (plugin %s)", hook.getType(), plugin.getMetaInformation().getName().c_str());
+                continue;
+            }
+            // Only the first hook of each type is called per plugin.
+            if (firstHookOfType[hook.getType()] == nullptr) {
+                firstHookOfType[hook.getType()] = &hook;
+                counts[hook.getType()]++;
+            }
+        }
+    }
+
+    mOffsets[0] = 0;
+    for (uint32_t i = 0; i < WUPS_LOADER_HOOK_TYPE_COUNT; i++) {
+        mOffsets[i + 1] = mOffsets[i] + counts[i];
+    }
+    mEntries.resize(mOffsets[WUPS_LOADER_HOOK_TYPE_COUNT]);
+
+    auto writePos = mOffsets;
+    for (const auto &plugin : plugins) {
+        if (filter != nullptr && !filter(plugin)) {
+            continue;
+        }
+        firstHookOfType.fill(nullptr);
+        for (const auto &hook : plugin.getPluginInformation().getHookDataList()) {
+            if ((uint32_t) hook.getType() >= WUPS_LOADER_HOOK_TYPE_COUNT || firstHookOfType[hook.getType()] != nullptr) {
+                continue;
+            }
+            firstHookOfType[hook.getType()]      = &hook;
+            mEntries[writePos[hook.getType()]++] = {.functionPointer = hook.getFunctionPointer(), .plugin = &plugin};
+        }
+    }
+}
+
+void HookDispatchTable::clear() {
+    mEntries.clear();
+    mOffsets.fill(0);
+}
+
+std::span<const HookDispatchEntry> HookDispatchTable::getEntries(wups_loader_hook_type_t type) const {
+    if ((uint32_t) type >= WUPS_LOADER_HOOK_TYPE_COUNT) {
+        return {};
+    }
+    return std::span(mEntries).subspan(mOffsets[type], mOffsets[type + 1] - mOffsets[type]);
+}
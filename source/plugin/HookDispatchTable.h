@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <wups/hooks.h>
+
+#define WUPS_LOADER_HOOK_TYPE_COUNT (WUPS_LOADER_HOOK_INIT_CONFIG + 1)
+
+class PluginContainer;
+
+struct HookDispatchEntry {
+    void *functionPointer;
+    const PluginContainer *plugin;
+};
+
+/**
+ * Hooks of a list of plugins, grouped by hook type.
+ * All entries of a hook type are stored next to each other in plugin order, so calling a hook
+ * only touches the plugins that actually registered it.
+ *
+ * The table references the PluginContainers directly and must be rebuilt whenever they are moved.
+ */
+class HookDispatchTable {
+public:
+    HookDispatchTable() = default;
+
+    explicit HookDispatchTable(std::span<const PluginContainer> plugins);
+
+    /**
+     * Only includes the hooks of plugins that match the filter.
+     */
+    HookDispatchTable(std::span<const PluginContainer> plugins, bool (*filter)(const PluginContainer &));
+
+    void clear();
+
+    [[nodiscard]] std::span<const HookDispatchEntry> getEntries(wups_loader_hook_type_t type) const;
+
+private:
+    std::vector<HookDispatchEntry> mEntries;
+    // Entries of hook type i are stored in [mOffsets[i], mOffsets[i + 1])
+    std::array<uint32_t, WUPS_LOADER_HOOK_TYPE_COUNT + 1> mOffsets{};
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <coreinit/time.h>
+#include <cstdint>
+
+/**
+ * Rolling execution time of a single hook type of a plugin, measured in OSGetSystemTime ticks.
+ */
+struct HookTimingStats {
+    uint32_t count           = 0;
+    uint32_t overBudgetCount = 0;
+    OSTime last              = 0;
+    OSTime max               = 0;
+    OSTime total             = 0;
+
+    void add(OSTime duration, bool overBudget) {
+        count++;
+        if (overBudget) {
+            overBudgetCount++;
+        }
+        last = duration;
+        total += duration;
+        if (duration > max) {
+            max = duration;
+        }
+    }
+};
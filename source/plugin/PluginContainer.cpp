@@ -1,16 +1,30 @@
 #include "PluginContainer.h"
+#include <atomic>
+#include <mutex>
+
+namespace {
+    // Hook timings are recorded by the worker threads of concurrent hooks and read via the API.
+    std::mutex sHookTimingStatsMutex;
+    // Plugins are also created by the preparation on another core. Starts at 1, so 0 is never a valid handle.
+    std::atomic<uint32_t> sNextHandle = 1;
+} // namespace
 
 PluginContainer::PluginContainer(PluginMetaInformation metaInformation, PluginInformation pluginInformation, std::shared_ptr<PluginData> pluginData)
     : mMetaInformation(std::move(metaInformation)),
       mPluginInformation(std::move(pluginInformation)),
-      mPluginData(std::move(pluginData)) {
+      mPluginData(std::move(pluginData)),
+      mHandle(sNextHandle++) {
 }
 
 PluginContainer::PluginContainer(PluginContainer &&src) : mMetaInformation(std::move(src.mMetaInformation)),
                                                           mPluginInformation(std::move(src.mPluginInformation)),
                                                           mPluginData(std::move(src.mPluginData)),
+                                                          mHandle(src.mHandle),
                                                           mPluginConfigData(std::move(src.mPluginConfigData)),
-                                                          storageRootItem(src.storageRootItem)
+                                                          storageRootItem(src.storageRootItem),
+                                                          mActive(src.mActive),
+                                                          mInitialized(src.mInitialized),
+                                                          mHookTimingStats(src.mHookTimingStats)
 
 {
     src.storageRootItem = {};
@@ -21,8 +35,12 @@ PluginContainer &PluginContainer::operator=(PluginContainer &&src) {
         this->mMetaInformation   = src.mMetaInformation;
         this->mPluginInformation = std::move(src.mPluginInformation);
         this->mPluginData        = std::move(src.mPluginData);
+        this->mHandle            = src.mHandle;
         this->mPluginConfigData  = std::move(src.mPluginConfigData);
         this->storageRootItem    = src.storageRootItem;
+        this->mActive            = src.mActive;
+        this->mInitialized       = src.mInitialized;
+        this->mHookTimingStats   = src.mHookTimingStats;
 
         src.storageRootItem = nullptr;
     }
@@ -46,14 +64,14 @@ std::shared_ptr<PluginData> PluginContainer::getPluginDataCopy() const {
 }
 
 uint32_t PluginContainer::getHandle() const {
-    return (uint32_t) this;
+    return mHandle;
 }
 
 const std::optional<PluginConfigData> &PluginContainer::getConfigData() const {
     return mPluginConfigData;
 }
 
-void PluginContainer::setConfigData(const PluginConfigData &pluginConfigData) {
+void PluginContainer::setConfigData(const PluginConfigData &pluginConfigData) const {
     mPluginConfigData = pluginConfigData;
 }
 
@@ -81,3 +99,17 @@ WUPSStorageError PluginContainer::CloseStorage() {
     }
     return StorageUtils::API::Internal::CloseStorage(storageRootItem);
 }
+
+HookTimingStats PluginContainer::getHookTimingStats(wups_loader_hook_type_t type) const {
+    std::lock_guard lock(sHookTimingStatsMutex);
+    return mHookTimingStats[type];
+}
+
+HookTimingStats PluginContainer::addHookDuration(wups_loader_hook_type_t type, OSTime duration, bool overBudget) const {
+    if ((uint32_t) type >= WUPS_LOADER_HOOK_TYPE_COUNT) {
+        return {};
+    }
+    std::lock_guard lock(sHookTimingStatsMutex);
+    mHookTimingStats[type].add(duration, overBudget);
+    return mHookTimingStats[type];
+}
\ No newline at end of file
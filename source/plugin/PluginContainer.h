@@ -17,11 +17,14 @@
 
 #pragma once
 
+#include "HookDispatchTable.h"
+#include "HookTimingStats.h"
 #include "PluginConfigData.h"
 #include "PluginData.h"
 #include "PluginInformation.h"
 #include "PluginMetaInformation.h"
 #include "utils/storage/StorageUtils.h"
+#include <array>
 #include <memory>
 #include <utility>
 #include <wups/config_api.h>
@@ -46,11 +49,16 @@ public:
 
     [[nodiscard]] std::shared_ptr<PluginData> getPluginDataCopy() const;
 
+    /**
+     * Identifies the plugin as long as it's loaded, it moves with the container. Kept plugins are not initialized again
+     * after a reload, so the handle they got via WUPS_LOADER_HOOK_INIT_CONFIG needs to stay valid.
+     */
     [[nodiscard]] uint32_t getHandle() const;
 
     [[nodiscard]] const std::optional<PluginConfigData> &getConfigData() const;
 
-    void setConfigData(const PluginConfigData &pluginConfigData);
+    // Set by the plugin itself via the config API while the plugin list is published, it is not part of the plugin list.
+    void setConfigData(const PluginConfigData &pluginConfigData) const;
 
     WUPSStorageError OpenStorage();
 
@@ -60,11 +68,50 @@ public:
         return storageRootItem;
     }
 
+    /**
+     * Inactive plugins are not patched or hooked for the current title. They are only relocated if they have been initialized before.
+     */
+    [[nodiscard]] bool isActive() const {
+        return mActive;
+    }
+
+    void setActive(bool active) {
+        mActive = active;
+    }
+
+    /**
+     * Whether the init hooks of this plugin have been called. Plugins are only initialized once they are active for the first time.
+     * Set right before the init hooks are called, the plugin can't be modified anymore while they run.
+     */
+    [[nodiscard]] bool isInitialized() const {
+        return mInitialized;
+    }
+
+    void setInitialized() {
+        mInitialized = true;
+    }
+
+    /**
+     * Hooks may be called on worker threads, so the statistics are returned as a copy.
+     */
+    [[nodiscard]] HookTimingStats getHookTimingStats(wups_loader_hook_type_t type) const;
+
+    /**
+     * Only statistics, so recording them does not change the logical state of the plugin.
+     * @return the statistics of the hook type including the given call.
+     */
+    HookTimingStats addHookDuration(wups_loader_hook_type_t type, OSTime duration, bool overBudget) const;
+
 private:
     PluginMetaInformation mMetaInformation;
     PluginInformation mPluginInformation;
     std::shared_ptr<PluginData> mPluginData;
+    uint32_t mHandle;
 
-    std::optional<PluginConfigData> mPluginConfigData;
+    mutable std::optional<PluginConfigData> mPluginConfigData;
     wups_storage_root_item storageRootItem = nullptr;
+    bool mActive                           = true;
+    bool mInitialized                      = false;
+
+    mutable std::array<HookTimingStats, WUPS_LOADER_HOOK_TYPE_COUNT> mHookTimingStats{};
 };
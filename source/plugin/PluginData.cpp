@@ -1,4 +1,6 @@
 #include "PluginData.h"
+#include <algorithm>
+#include <functional>
 
 uint32_t PluginData::getHandle() const {
     return (uint32_t) this;
@@ -11,3 +13,22 @@ std::span<const uint8_t> PluginData::getBuffer() const {
 const std::string &PluginData::getSource() const {
     return mSource;
 }
+
+
+size_t PluginData::getHash() const {
+    return mHash;
+}
+
+bool PluginData::hasSameContent(const PluginData &other) const {
+    if (this == &other) {
+        return true;
+    }
+    if (mHash != other.mHash || mBuffer.size() != other.mBuffer.size()) {
+        return false;
+    }
+    return std::ranges::equal(mBuffer, other.mBuffer);
+}
+
+size_t PluginData::calculateHash(std::span<const uint8_t> buffer) {
+    return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(buffer.data()), buffer.size()));
+}
\ No newline at end of file
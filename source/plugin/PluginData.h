@@ -22,15 +22,17 @@
 #include <memory>
 #include <optional>
 #include <span>
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 class PluginData {
 public:
-    explicit PluginData(std::vector<uint8_t> &&buffer, std::string_view source) : mBuffer(std::move(buffer)), mSource(source) {
+    explicit PluginData(std::vector<uint8_t> &&buffer, std::string_view source) : mBuffer(std::move(buffer)), mSource(source), mHash(calculateHash(mBuffer)) {
     }
 
-    explicit PluginData(std::span<uint8_t> buffer, std::string_view source) : mBuffer(buffer.begin(), buffer.end()), mSource(source) {
+    explicit PluginData(std::span<uint8_t> buffer, std::string_view source) : mBuffer(buffer.begin(), buffer.end()), mSource(source), mHash(calculateHash(mBuffer)) {
     }
 
     [[nodiscard]] uint32_t getHandle() const;
@@ -39,7 +41,18 @@ public:
 
     [[nodiscard]] const std::string &getSource() const;
 
+    [[nodiscard]] size_t getHash() const;
+
+    /**
+     * Returns true if both plugin data objects hold the same plugin binary.
+     * The hashes are compared first, the buffers only if the hashes match.
+     */
+    [[nodiscard]] bool hasSameContent(const PluginData &other) const;
+
 private:
+    static size_t calculateHash(std::span<const uint8_t> buffer);
+
     std::vector<uint8_t> mBuffer;
     std::string mSource;
+    size_t mHash = 0;
 };
@@ -26,17 +26,22 @@
 
 std::set<std::shared_ptr<PluginData>> PluginDataFactory::loadDir(std::string_view path) {
     std::set<std::shared_ptr<PluginData>> result;
+    loadDir(path, [&result](std::unique_ptr<PluginData> pluginData) { result.insert(std::move(pluginData)); });
+    return result;
+}
+
+void PluginDataFactory::loadDir(std::string_view path, const std::function<void(std::unique_ptr<PluginData>)> &onLoaded) {
     struct dirent *dp;
     DIR *dfd;
 
     if (path.empty()) {
         DEBUG_FUNCTION_LINE_ERR("Failed to load Plugins from dir: Path was empty");
-        return result;
+        return;
     }
 
     if ((dfd = opendir(path.data())) == nullptr) {
         DEBUG_FUNCTION_LINE_ERR("Couldn't open dir %s", path.data());
-        return result;
+        return;
     }
 
     while ((dp = readdir(dfd)) != nullptr) {
@@ -52,7 +57,7 @@ std::set<std::shared_ptr<PluginData>> PluginDataFactory::loadDir(std::string_vie
         DEBUG_FUNCTION_LINE("Loading plugin: %s", full_file_path.c_str());
         auto pluginData = load(full_file_path);
         if (pluginData) {
-            result.insert(std::move(pluginData));
+            onLoaded(std::move(pluginData));
         } else {
             auto errMsg = string_format("Failed to load plugin: %s", full_file_path.c_str());
             DEBUG_FUNCTION_LINE_ERR("%s", errMsg.c_str());
@@ -61,8 +66,6 @@ std::set<std::shared_ptr<PluginData>> PluginDataFactory::loadDir(std::string_vie
     }
 
     closedir(dfd);
-
-    return result;
 }
 
 std::unique_ptr<PluginData> PluginDataFactory::load(std::string_view filename) {
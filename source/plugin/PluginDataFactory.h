@@ -20,6 +20,7 @@
 #include "PluginData.h"
 #include <coreinit/memexpheap.h>
 #include <forward_list>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <set>
@@ -30,6 +31,11 @@ class PluginDataFactory {
 public:
     static std::set<std::shared_ptr<PluginData>> loadDir(std::string_view path);
 
+    /**
+     * Calls onLoaded for every plugin of the directory as soon as it has been loaded into memory.
+     */
+    static void loadDir(std::string_view path, const std::function<void(std::unique_ptr<PluginData>)> &onLoaded);
+
     static std::unique_ptr<PluginData> load(std::string_view path);
 
     static std::unique_ptr<PluginData> load(std::vector<uint8_t> &&buffer, std::string_view source);
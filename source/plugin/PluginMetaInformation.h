@@ -18,6 +18,8 @@
 #pragma once
 
 #include "WUPSVersion.h"
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -55,6 +57,20 @@ public:
         return this->storageId;
     }
 
+    /**
+     * Whether INIT_PLUGIN and APPLICATION_STARTS of this plugin may run on a worker thread, concurrently with the hooks of other plugins.
+     */
+    [[nodiscard]] bool allowsConcurrentHooks() const {
+        return this->concurrentHooks;
+    }
+
+    /**
+     * Plugins without a "title_ids" list in their meta data are active for every title.
+     */
+    [[nodiscard]] bool isActiveForTitle(uint64_t titleId) const {
+        return this->activeTitleIds.empty() || std::ranges::find(this->activeTitleIds, titleId) != this->activeTitleIds.end();
+    }
+
     [[nodiscard]] size_t getSize() const {
         return this->size;
     }
@@ -102,6 +118,14 @@ private:
         this->storageId = std::move(_storageId);
     }
 
+    void setAllowsConcurrentHooks(bool _concurrentHooks) {
+        this->concurrentHooks = _concurrentHooks;
+    }
+
+    void addActiveTitleId(uint64_t titleId) {
+        this->activeTitleIds.push_back(titleId);
+    }
+
     std::string name;
     std::string author;
     std::string version;
@@ -110,6 +134,8 @@ private:
     std::string description;
     std::string storageId;
     size_t size{};
+    bool concurrentHooks = false;
+    std::vector<uint64_t> activeTitleIds;
     WUPSVersion wupsversion = WUPSVersion(0, 0, 0);
 
     friend class PluginMetaInformationFactory;
@@ -20,6 +20,7 @@
 #include "fs/FSUtils.h"
 #include "utils/logger.h"
 #include "utils/wiiu_zlib.hpp"
+#include <cstdlib>
 #include <memory>
 
 std::optional<PluginMetaInformation> PluginMetaInformationFactory::loadPlugin(const PluginData &pluginData, PluginParseErrors &error) {
@@ -104,6 +105,21 @@ std::optional<PluginMetaInformation> PluginMetaInformationFactory::loadPlugin(st
                         pluginInfo.setDescription(value);
                     } else if (key == "storage_id") {
                         pluginInfo.setStorageId(value);
+                    } else if (key == "concurrent_hooks") {
+                        pluginInfo.setAllowsConcurrentHooks(value == "true");
+                    } else if (key == "title_ids") {
+                        // Comma separated list of title ids in hex, e.g. "0005000010101C00,0005000010101D00"
+                        const char *curTitleId = value.c_str();
+                        while (*curTitleId != '\0') {
+                            char *end;
+                            auto titleId = strtoull(curTitleId, &end, 16);
+                            if (end == curTitleId) {
+                                DEBUG_FUNCTION_LINE_WARN("Ignoring invalid title id list: %s", value.c_str());
+                                break;
+                            }
+                            pluginInfo.addActiveTitleId(titleId);
+                            curTitleId = (*end == ',') ? end + 1 : end;
+                        }
                     } else if (key == "wups") {
                         if (value == "0.7.1") {
                             pluginInfo.setWUPSVersion(0, 7, 1);
@@ -0,0 +1,108 @@
+#include "PluginPreparation.h"
+#include "PluginManagement.h"
+#include "PluginMetaInformationFactory.h"
+#include "globals.h"
+#include "utils/TaskRuntime.h"
+#include "utils/logger.h"
+#include <condition_variable>
+
+namespace {
+    // Any number of threads may wait for the preparation, e.g. WUPSLoadAndLinkByDataHandle and WUMS_APPLICATION_STARTS.
+    std::mutex sPreparingMutex;
+    std::condition_variable sPreparationDone;
+    bool sPreparing = false;
+
+    void SetPreparing(bool preparing) {
+        {
+            std::lock_guard<std::mutex> lock(sPreparingMutex);
+            sPreparing = preparing;
+        }
+        sPreparationDone.notify_all();
+    }
+
+    std::set<std::shared_ptr<PluginData>> sPluginDataToPrepare;
+    std::vector<PluginContainer> sPreparedPlugins;
+
+    Task<> Prepare() {
+        {
+            std::lock_guard<std::mutex> lock(gLoadedDataMutex);
+            // Don't use any trampoline id of a plugin that is currently loaded, they might be kept on the next launch.
+            sPreparedPlugins = PluginManagement::layoutPlugins(sPluginDataToPrepare, gTrampData, gLoadedPlugins);
+            DEBUG_FUNCTION_LINE("Prepared %d of %d plugins for the next launch", sPreparedPlugins.size(), sPluginDataToPrepare.size());
+            sPluginDataToPrepare.clear();
+        }
+        SetPreparing(false);
+        co_return;
+    }
+
+    void Discard() {
+        PluginManagement::freeTrampolines(sPreparedPlugins, gTrampData);
+        sPreparedPlugins.clear();
+    }
+
+    bool IsLoaded(const std::shared_ptr<PluginData> &pluginData) {
+        return std::ranges::any_of(gLoadedPlugins, [&pluginData](const auto &plugin) {
+            auto loadedData = plugin.getPluginDataCopy();
+            return loadedData == pluginData || loadedData->hasSameContent(*pluginData);
+        });
+    }
+} // namespace
+
+void PluginPreparation::WaitUntilDone() {
+    std::unique_lock<std::mutex> lock(sPreparingMutex);
+    sPreparationDone.wait(lock, [] { return !sPreparing; });
+}
+
+PluginBackendApiErrorType PluginPreparation::Validate(const std::set<std::shared_ptr<PluginData>> &pluginDataList) {
+    auto res = PLUGIN_BACKEND_API_ERROR_NONE;
+    for (const auto &pluginData : pluginDataList) {
+        if (IsLoaded(pluginData)) {
+            continue;
+        }
+        PluginParseErrors error = PLUGIN_PARSE_ERROR_UNKNOWN;
+        auto metaInfo           = PluginMetaInformationFactory::loadPlugin(*pluginData, error);
+        if (!metaInfo || error != PLUGIN_PARSE_ERROR_NONE) {
+            DEBUG_FUNCTION_LINE_ERR("Plugin %s is invalid", pluginData->getSource().c_str());
+            res = PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
+        }
+    }
+    return res;
+}
+
+void PluginPreparation::Start(const std::set<std::shared_ptr<PluginData>> &pluginDataList) {
+    Discard();
+
+    for (const auto &pluginData : pluginDataList) {
+        if (!IsLoaded(pluginData)) {
+            sPluginDataToPrepare.insert(pluginData);
+        }
+    }
+
+    if (sPluginDataToPrepare.empty()) {
+        return;
+    }
+
+    // The caller holds gLoadedDataMutex, so the preparation must not run synchronously on this thread.
+    // Set before spawning, the preparation might already be done when Spawn returns.
+    SetPreparing(true);
+    if (!TaskRuntime::IsRunning() || !TaskRuntime::Spawn(Prepare())) {
+        // Not fatal, the plugins will be loaded on the next launch as usual.
+        DEBUG_FUNCTION_LINE_WARN("Failed to start preparing plugins");
+        sPluginDataToPrepare.clear();
+        SetPreparing(false);
+    }
+}
+
+void PluginPreparation::TakePrepared(std::set<std::shared_ptr<PluginData>> &pluginDataToLoad, std::vector<PluginContainer> &outPlugins) {
+    for (auto &plugin : sPreparedPlugins) {
+        auto it = pluginDataToLoad.find(plugin.getPluginDataCopy());
+        if (it == pluginDataToLoad.end()) {
+            continue;
+        }
+        pluginDataToLoad.erase(it);
+        outPlugins.push_back(std::move(plugin));
+    }
+    // outPlugins took over everything that is still needed.
+    std::erase_if(sPreparedPlugins, [](const auto &plugin) { return plugin.getPluginDataCopy() == nullptr; });
+    Discard();
+}
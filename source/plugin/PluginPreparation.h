@@ -0,0 +1,39 @@
+#pragma once
+
+#include "PluginContainer.h"
+#include "PluginData.h"
+#include <memory>
+#include <set>
+#include <vector>
+#include <wups_backend/import_defines.h>
+
+/**
+ * Prepares the plugins that will be loaded on the next launch ahead of time.
+ * Everything that doesn't depend on the next title (parsing, allocating and laying out the sections) is done on a CPU worker of the TaskRuntime,
+ * only patching the functions and binding the imports is left for the next WUMS_APPLICATION_STARTS.
+ *
+ * Validate, Start and TakePrepared must be called while holding gLoadedDataMutex, after WaitUntilDone.
+ */
+namespace PluginPreparation {
+    /**
+     * Waits until the preparation is done. Must NOT be called while holding gLoadedDataMutex, the preparation needs it.
+     */
+    void WaitUntilDone();
+
+    /**
+     * Checks the meta information of all plugins in pluginDataList that are not loaded yet.
+     * @return PLUGIN_BACKEND_API_ERROR_INVALID_ARG if at least one plugin is invalid.
+     */
+    PluginBackendApiErrorType Validate(const std::set<std::shared_ptr<PluginData>> &pluginDataList);
+
+    /**
+     * Discards the previous preparation and starts laying out all plugins in pluginDataList that are not loaded yet in the background.
+     */
+    void Start(const std::set<std::shared_ptr<PluginData>> &pluginDataList);
+
+    /**
+     * Moves all prepared plugins whose plugin data is part of pluginDataToLoad to outPlugins.
+     * These plugins are removed from pluginDataToLoad. Prepared plugins that are not needed anymore are discarded.
+     */
+    void TakePrepared(std::set<std::shared_ptr<PluginData>> &pluginDataToLoad, std::vector<PluginContainer> &outPlugins);
+} // namespace PluginPreparation
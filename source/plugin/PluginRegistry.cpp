@@ -0,0 +1,52 @@
+#include "PluginRegistry.h"
+#include <array>
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+
+namespace {
+    // Only one snapshot is replaced at a time, so two are enough. The previous one is only reused after all of its readers are done.
+    std::array<PluginRegistrySnapshot, 2> sSnapshots;
+    std::atomic<PluginRegistrySnapshot *> sCurrentSnapshot = &sSnapshots[0];
+
+    void WaitForReaders(const PluginRegistrySnapshot &snapshot) {
+        while (snapshot.readers.load(std::memory_order_seq_cst) != 0) {
+            OSSleepTicks(OSMicrosecondsToTicks(100));
+        }
+    }
+} // namespace
+
+PluginRegistry::ReadGuard::ReadGuard() {
+    while (true) {
+        auto *snapshot = sCurrentSnapshot.load(std::memory_order_acquire);
+        // Reader: increment readers, then load sCurrentSnapshot. Writer: store sCurrentSnapshot, then load readers.
+        // Both sides need seq_cst, otherwise each side may miss the write of the other one and the writer reuses a snapshot that is still read.
+        snapshot->readers.fetch_add(1, std::memory_order_seq_cst);
+        // The snapshot might have been replaced between loading and incrementing the reader count, in that case it might be reused already.
+        if (sCurrentSnapshot.load(std::memory_order_seq_cst) == snapshot) {
+            mSnapshot = snapshot;
+            return;
+        }
+        snapshot->readers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+PluginRegistry::ReadGuard::~ReadGuard() {
+    mSnapshot->readers.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void PluginRegistry::Publish(std::span<const PluginContainer> plugins) {
+    auto *oldSnapshot = sCurrentSnapshot.load(std::memory_order_acquire);
+    auto *newSnapshot = oldSnapshot == &sSnapshots[0] ? &sSnapshots[1] : &sSnapshots[0];
+
+    // Readers that loaded this snapshot right before it got replaced may still be around.
+    WaitForReaders(*newSnapshot);
+    newSnapshot->plugins = plugins;
+    newSnapshot->hooks   = HookDispatchTable(plugins, [](const PluginContainer &plugin) { return plugin.isActive(); });
+
+    sCurrentSnapshot.store(newSnapshot, std::memory_order_seq_cst);
+    WaitForReaders(*oldSnapshot);
+}
+
+void PluginRegistry::Clear() {
+    Publish({});
+}
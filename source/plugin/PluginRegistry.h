@@ -0,0 +1,62 @@
+#pragma once
+
+#include "HookDispatchTable.h"
+#include "PluginContainer.h"
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+/**
+ * Immutable view of the loaded plugins. Changes of the plugin list are published as a new snapshot.
+ */
+struct PluginRegistrySnapshot {
+    std::span<const PluginContainer> plugins;
+    // Hooks of all active plugins.
+    HookDispatchTable hooks;
+
+    // Number of readers currently using this snapshot.
+    std::atomic<uint32_t> readers = 0;
+};
+
+/**
+ * RCU-style access to the loaded plugins.
+ * Readers never block and never see a half-built plugin list. They can be used from any thread without holding gLoadedDataMutex.
+ * Publishing a new snapshot waits until all readers of the previous one are done.
+ */
+class PluginRegistry {
+public:
+    /**
+     * Keeps the current snapshot alive while in scope.
+     * Don't wait for anything that is only released after a new snapshot has been published while holding a ReadGuard.
+     */
+    class ReadGuard {
+    public:
+        ReadGuard();
+
+        ReadGuard(const ReadGuard &) = delete;
+
+        ~ReadGuard();
+
+        const PluginRegistrySnapshot *operator->() const {
+            return mSnapshot;
+        }
+
+        const PluginRegistrySnapshot &operator*() const {
+            return *mSnapshot;
+        }
+
+    private:
+        PluginRegistrySnapshot *mSnapshot;
+    };
+
+    /**
+     * Publishes a snapshot of the given plugins. The plugins must not be modified (or moved) until the next call of Publish or Clear.
+     * Must only be called by one thread at a time.
+     */
+    static void Publish(std::span<const PluginContainer> plugins);
+
+    /**
+     * Publishes an empty snapshot, needs to be called before modifying the previously published plugins.
+     */
+    static void Clear();
+};
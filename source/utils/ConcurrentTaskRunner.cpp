@@ -0,0 +1,48 @@
+#include "ConcurrentTaskRunner.h"
+#include "logger.h"
+#include <algorithm>
+
+// The calling thread takes part as well, so use one worker per other core.
+#define NUMBER_OF_WORKERS 2
+
+ConcurrentTaskRunner::ConcurrentTaskRunner(std::function<void(uint32_t)> task, uint32_t count) : mTask(std::move(task)), mCount(count) {
+}
+
+ConcurrentTaskRunner::~ConcurrentTaskRunner() {
+    join();
+}
+
+void ConcurrentTaskRunner::start() {
+    if (mCount < 2 || !TaskRuntime::IsRunning()) {
+        // Not worth waking up a worker.
+        return;
+    }
+    for (uint32_t i = 0; i < std::min<uint32_t>(mCount - 1, NUMBER_OF_WORKERS); i++) {
+        if (!TaskRuntime::Spawn(runTasksOnWorker())) {
+            DEBUG_FUNCTION_LINE_ERR("Failed to spawn task");
+            break;
+        }
+        mNumberOfWorkers++;
+    }
+}
+
+void ConcurrentTaskRunner::join() {
+    runTasks();
+    for (; mNumberOfWorkers > 0; mNumberOfWorkers--) {
+        mWorkersDone.wait();
+    }
+}
+
+Task<> ConcurrentTaskRunner::runTasksOnWorker() {
+    runTasks();
+    // Nothing of this runner may be accessed after this, join() returns as soon as all workers have signaled.
+    mWorkersDone.signal();
+    co_return;
+}
+
+void ConcurrentTaskRunner::runTasks() {
+    uint32_t index;
+    while ((index = mNextTask++) < mCount) {
+        mTask(index);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "TaskRuntime.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+/**
+ * Executes task(0) ... task(count - 1) on the CPU workers of the TaskRuntime.
+ * The calling thread can do other work after start() and takes part in executing the tasks when calling join().
+ * Tasks are picked up in order, but may finish in any order.
+ *
+ * Must not be used from a worker of the TaskRuntime.
+ */
+class ConcurrentTaskRunner {
+public:
+    ConcurrentTaskRunner(std::function<void(uint32_t)> task, uint32_t count);
+
+    ConcurrentTaskRunner(const ConcurrentTaskRunner &) = delete;
+
+    ~ConcurrentTaskRunner();
+
+    /**
+     * Hands the tasks to the TaskRuntime. If it is not running, all tasks will be executed by join().
+     */
+    void start();
+
+    /**
+     * Executes the remaining tasks on the current thread and waits until the workers have finished.
+     */
+    void join();
+
+private:
+    Task<> runTasksOnWorker();
+
+    void runTasks();
+
+    std::function<void(uint32_t)> mTask;
+    uint32_t mCount;
+    std::atomic<uint32_t> mNextTask = 0;
+    uint32_t mNumberOfWorkers       = 0;
+    TaskSemaphore mWorkersDone;
+};
@@ -0,0 +1,178 @@
+#include "FrameCallbacks.h"
+#include "globals.h"
+#include "logger.h"
+#include "plugin/HookTimingStats.h"
+#include "plugin/PluginRegistry.h"
+#include <array>
+#include <mutex>
+
+#define MAX_FRAME_CALLBACKS 32
+
+namespace {
+    struct FrameCallback {
+        wups_backend_frame_callback_handle handle;
+        WUPSBackendFrameCallbackFn callback;
+        void *context;
+        // Plugin that provides the callback, 0 if it doesn't belong to a loaded plugin.
+        wups_backend_plugin_container_handle plugin;
+        // false while the plugin providing the callback is inactive.
+        bool enabled;
+        HookTimingStats stats;
+    };
+
+    // Preallocated so dispatching never allocates memory.
+    std::array<FrameCallback, MAX_FRAME_CALLBACKS> sCallbacks{};
+    // Only held while accessing the list, never while a callback is running.
+    std::mutex sCallbacksMutex;
+    uint32_t sNextHandle = 1;
+
+    FrameCallback *FindCallback(wups_backend_frame_callback_handle handle) {
+        for (auto &cur : sCallbacks) {
+            if (cur.callback != nullptr && cur.handle == handle) {
+                return &cur;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Plugins add their callbacks while they are initialized or started, the plugin list has already been published then.
+     */
+    wups_backend_plugin_container_handle FindPluginOfCallback(WUPSBackendFrameCallbackFn callback) {
+        PluginRegistry::ReadGuard registry;
+        for (const auto &plugin : registry->plugins) {
+            const auto textSection = plugin.getPluginInformation().getSectionInfo(".text");
+            if (textSection && textSection->isInSection((uint32_t) callback)) {
+                return plugin.getHandle();
+            }
+        }
+        return 0;
+    }
+} // namespace
+
+PluginBackendApiErrorType FrameCallbacks::AddCallback(WUPSBackendFrameCallbackFn callback, void *context, wups_backend_frame_callback_handle *outHandle) {
+    if (callback == nullptr || outHandle == nullptr) {
+        return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
+    }
+    auto plugin = FindPluginOfCallback(callback);
+    std::lock_guard<std::mutex> lock(sCallbacksMutex);
+    for (auto &cur : sCallbacks) {
+        if (cur.callback == nullptr) {
+            cur        = {.handle = sNextHandle++, .callback = callback, .context = context, .plugin = plugin, .enabled = true, .stats = {}};
+            *outHandle = cur.handle;
+            return PLUGIN_BACKEND_API_ERROR_NONE;
+        }
+    }
+    DEBUG_FUNCTION_LINE_ERR("Failed to add frame callback, the limit of %d callbacks has been reached", MAX_FRAME_CALLBACKS);
+    return PLUGIN_BACKEND_API_ERROR_FAILED_ALLOC;
+}
+
+PluginBackendApiErrorType FrameCallbacks::RemoveCallback(wups_backend_frame_callback_handle handle) {
+    std::lock_guard<std::mutex> lock(sCallbacksMutex);
+    auto callback = FindCallback(handle);
+    if (!callback) {
+        return PLUGIN_BACKEND_API_INVALID_HANDLE;
+    }
+    *callback = {};
+    return PLUGIN_BACKEND_API_ERROR_NONE;
+}
+
+void FrameCallbacks::RemoveCallbacksOfPlugins(std::span<const PluginContainer> plugins) {
+    std::lock_guard<std::mutex> lock(sCallbacksMutex);
+    for (const auto &plugin : plugins) {
+        const auto textSection = plugin.getPluginInformation().getSectionInfo(".text");
+        if (!textSection) {
+            continue;
+        }
+        for (auto &cur : sCallbacks) {
+            if (cur.callback != nullptr && textSection->isInSection((uint32_t) cur.callback)) {
+                DEBUG_FUNCTION_LINE("Remove frame callback %d of plugin %s", cur.handle, plugin.getMetaInformation().getName().c_str());
+                cur = {};
+            }
+        }
+    }
+}
+
+void FrameCallbacks::UpdateActivation(std::span<const PluginContainer> plugins) {
+    std::lock_guard<std::mutex> lock(sCallbacksMutex);
+    for (const auto &plugin : plugins) {
+        const auto textSection = plugin.getPluginInformation().getSectionInfo(".text");
+        if (!textSection) {
+            continue;
+        }
+        for (auto &cur : sCallbacks) {
+            if (cur.callback != nullptr && textSection->isInSection((uint32_t) cur.callback)) {
+                cur.enabled = plugin.isActive();
+                cur.plugin  = plugin.getHandle();
+            }
+        }
+    }
+}
+
+PluginBackendApiErrorType FrameCallbacks::GetTimingStats(wups_backend_frame_callback_timing_info *timingInfoList, uint32_t bufferSize, uint32_t *outCount) {
+    if (outCount == nullptr || (timingInfoList == nullptr && bufferSize != 0)) {
+        return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(sCallbacksMutex);
+    uint32_t offset = 0;
+    for (const auto &cur : sCallbacks) {
+        if (cur.callback == nullptr || cur.stats.count == 0) {
+            continue;
+        }
+        if (offset >= bufferSize) {
+            break;
+        }
+        auto &info                              = timingInfoList[offset];
+        info.frame_callback_timing_info_version = WUPS_BACKEND_FRAME_CALLBACK_TIMING_INFORMATION_VERSION;
+        info.handle                             = cur.handle;
+        info.plugin                             = cur.plugin;
+        info.count                              = cur.stats.count;
+        info.overBudgetCount                    = cur.stats.overBudgetCount;
+        info.lastInMicroseconds                 = OSTicksToMicroseconds(cur.stats.last);
+        info.maxInMicroseconds                  = OSTicksToMicroseconds(cur.stats.max);
+        info.totalInMicroseconds                = OSTicksToMicroseconds(cur.stats.total);
+        offset++;
+    }
+    *outCount = offset;
+    return PLUGIN_BACKEND_API_ERROR_NONE;
+}
+
+void FrameCallbacks::Dispatch() {
+    // Callbacks may add or remove callbacks, so they are called on a copy without holding the lock.
+    struct PendingCall {
+        wups_backend_frame_callback_handle handle;
+        WUPSBackendFrameCallbackFn callback;
+        void *context;
+    };
+    std::array<PendingCall, MAX_FRAME_CALLBACKS> calls;
+    uint32_t numberOfCalls = 0;
+    {
+        std::lock_guard<std::mutex> lock(sCallbacksMutex);
+        for (const auto &cur : sCallbacks) {
+            if (cur.callback != nullptr && cur.enabled) {
+                calls[numberOfCalls++] = {.handle = cur.handle, .callback = cur.callback, .context = cur.context};
+            }
+        }
+    }
+
+    uint32_t budget = gHookTimeBudgetInMicroseconds;
+    for (uint32_t i = 0; i < numberOfCalls; i++) {
+        const auto &call = calls[i];
+        auto startTime   = OSGetSystemTime();
+        call.callback(call.context);
+        auto duration   = OSGetSystemTime() - startTime;
+        bool overBudget = budget != 0 && OSTicksToMicroseconds(duration) > budget;
+
+        std::lock_guard<std::mutex> lock(sCallbacksMutex);
+        // The callback might have removed itself.
+        auto callback = FindCallback(call.handle);
+        if (!callback) {
+            continue;
+        }
+        callback->stats.add(duration, overBudget);
+        // Called every frame, only the first overrun is logged, all others are counted.
+        if (overBudget && callback->stats.overBudgetCount == 1) {
+            DEBUG_FUNCTION_LINE_WARN("Frame callback %d (%08X) took %lld us (budget: %d us)", call.handle, call.callback, OSTicksToMicroseconds(duration), budget);
+        }
+    }
+}
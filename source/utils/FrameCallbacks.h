@@ -0,0 +1,34 @@
+#pragma once
+
+#include "exports.h"
+#include "plugin/PluginContainer.h"
+#include <span>
+#include <wups_backend/import_defines.h>
+
+/**
+ * Lets plugins run a callback once per frame via the backend's existing GX2SwapScanBuffers replacement,
+ * instead of patching this function themselves.
+ */
+namespace FrameCallbacks {
+    /**
+     * The callback is assigned to the plugin whose .text section contains it, for the timing stats.
+     */
+    PluginBackendApiErrorType AddCallback(WUPSBackendFrameCallbackFn callback, void *context, wups_backend_frame_callback_handle *outHandle);
+
+    PluginBackendApiErrorType RemoveCallback(wups_backend_frame_callback_handle handle);
+
+    /**
+     * Removes all callbacks inside the .text section of one of the given plugins.
+     */
+    void RemoveCallbacksOfPlugins(std::span<const PluginContainer> plugins);
+
+    /**
+     * Disables the callbacks of plugins that are inactive for the current title, and enables the ones of active plugins.
+     * Also assigns callbacks that have been added while the plugins were not published to their plugins.
+     */
+    void UpdateActivation(std::span<const PluginContainer> plugins);
+
+    PluginBackendApiErrorType GetTimingStats(wups_backend_frame_callback_timing_info *timingInfoList, uint32_t bufferSize, uint32_t *outCount);
+
+    void Dispatch();
+} // namespace FrameCallbacks
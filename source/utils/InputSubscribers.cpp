@@ -0,0 +1,195 @@
+#include "InputSubscribers.h"
+#include "logger.h"
+#include <array>
+#include <cstring>
+#include <mutex>
+
+#define MAX_INPUT_SUBSCRIBERS 32
+#define MAX_VPAD_CHANNELS     2
+#define MAX_WPAD_CHANNELS     7
+
+// Sizes of the status structs WPADRead fills in for the data formats. Every format starts with the core status.
+#define WPAD_CORE_STATUS_SIZE           0x2A
+#define WPAD_NUNCHUK_STATUS_SIZE        0x32
+#define WPAD_CLASSIC_STATUS_SIZE        0x36
+#define WPAD_PRO_CONTROLLER_STATUS_SIZE 0x40
+#define WPAD_MAX_STATUS_SIZE            WPAD_PRO_CONTROLLER_STATUS_SIZE
+
+namespace {
+    enum InputDevice {
+        INPUT_DEVICE_NONE,
+        INPUT_DEVICE_VPAD,
+        INPUT_DEVICE_WPAD,
+    };
+
+    struct InputSubscriber {
+        wups_backend_input_subscriber_handle handle;
+        InputDevice device;
+        WUPSBackendInputSubscriberType type;
+        void *callback;
+        void *context;
+        // false while the plugin providing the callback is inactive.
+        bool enabled;
+    };
+
+    // Preallocated so reading the input never allocates memory.
+    std::array<InputSubscriber, MAX_INPUT_SUBSCRIBERS> sSubscribers{};
+    // Only held while accessing the list, never while a callback is running.
+    std::mutex sSubscribersMutex;
+    uint32_t sNextHandle = 1;
+
+    struct PendingCall {
+        WUPSBackendInputSubscriberType type;
+        void *callback;
+        void *context;
+    };
+
+    /**
+     * Subscribers may add or remove subscribers from within their callback, so they are called on a copy of the list.
+     * A subscriber that is removed while the input is dispatched might be called one last time.
+     */
+    uint32_t CollectCalls(InputDevice device, std::array<PendingCall, MAX_INPUT_SUBSCRIBERS> &outCalls) {
+        std::lock_guard<std::mutex> lock(sSubscribersMutex);
+        uint32_t count = 0;
+        for (const auto &subscriber : sSubscribers) {
+            if (subscriber.enabled && subscriber.device == device) {
+                outCalls[count++] = {.type = subscriber.type, .callback = subscriber.callback, .context = subscriber.context};
+            }
+        }
+        return count;
+    }
+
+    uint32_t GetWPADStatusSize(WPADDataFormat format) {
+        switch (format) {
+            case WPAD_FMT_NUNCHUK:
+            case WPAD_FMT_NUNCHUK_ACC:
+            case WPAD_FMT_NUNCHUK_ACC_DPD:
+                return WPAD_NUNCHUK_STATUS_SIZE;
+            case WPAD_FMT_CLASSIC:
+            case WPAD_FMT_CLASSIC_ACC:
+            case WPAD_FMT_CLASSIC_ACC_DPD:
+                return WPAD_CLASSIC_STATUS_SIZE;
+            case WPAD_FMT_PRO_CONTROLLER:
+                return WPAD_PRO_CONTROLLER_STATUS_SIZE;
+            default:
+                // Only the core status is known to be there.
+                return WPAD_CORE_STATUS_SIZE;
+        }
+    }
+
+    PluginBackendApiErrorType AddSubscriber(InputDevice device, WUPSBackendInputSubscriberType type, void *callback, void *context, wups_backend_input_subscriber_handle *outHandle) {
+        if (callback == nullptr || outHandle == nullptr ||
+            (type != WUPS_BACKEND_INPUT_SUBSCRIBER_OBSERVER && type != WUPS_BACKEND_INPUT_SUBSCRIBER_FILTER)) {
+            return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
+        }
+        std::lock_guard<std::mutex> lock(sSubscribersMutex);
+        for (auto &subscriber : sSubscribers) {
+            if (subscriber.device == INPUT_DEVICE_NONE) {
+                subscriber = {.handle = sNextHandle++, .device = device, .type = type, .callback = callback, .context = context, .enabled = true};
+                *outHandle = subscriber.handle;
+                return PLUGIN_BACKEND_API_ERROR_NONE;
+            }
+        }
+        DEBUG_FUNCTION_LINE_ERR("Failed to add input subscriber, the limit of %d subscribers has been reached", MAX_INPUT_SUBSCRIBERS);
+        return PLUGIN_BACKEND_API_ERROR_FAILED_ALLOC;
+    }
+} // namespace
+
+PluginBackendApiErrorType InputSubscribers::AddVPADSubscriber(WUPSBackendInputSubscriberType type, void *callback, void *context, wups_backend_input_subscriber_handle *outHandle) {
+    return AddSubscriber(INPUT_DEVICE_VPAD, type, callback, context, outHandle);
+}
+
+PluginBackendApiErrorType InputSubscribers::AddWPADSubscriber(WUPSBackendInputSubscriberType type, void *callback, void *context, wups_backend_input_subscriber_handle *outHandle) {
+    return AddSubscriber(INPUT_DEVICE_WPAD, type, callback, context, outHandle);
+}
+
+PluginBackendApiErrorType InputSubscribers::RemoveSubscriber(wups_backend_input_subscriber_handle handle) {
+    std::lock_guard<std::mutex> lock(sSubscribersMutex);
+    for (auto &subscriber : sSubscribers) {
+        if (subscriber.device != INPUT_DEVICE_NONE && subscriber.handle == handle) {
+            subscriber = {};
+            return PLUGIN_BACKEND_API_ERROR_NONE;
+        }
+    }
+    return PLUGIN_BACKEND_API_INVALID_HANDLE;
+}
+
+void InputSubscribers::RemoveSubscribersOfPlugins(std::span<const PluginContainer> plugins) {
+    std::lock_guard<std::mutex> lock(sSubscribersMutex);
+    for (const auto &plugin : plugins) {
+        const auto textSection = plugin.getPluginInformation().getSectionInfo(".text");
+        if (!textSection) {
+            continue;
+        }
+        for (auto &subscriber : sSubscribers) {
+            if (subscriber.device != INPUT_DEVICE_NONE && textSection->isInSection((uint32_t) subscriber.callback)) {
+                DEBUG_FUNCTION_LINE("Remove input subscriber %d of plugin %s", subscriber.handle, plugin.getMetaInformation().getName().c_str());
+                subscriber = {};
+            }
+        }
+    }
+}
+
+void InputSubscribers::UpdateActivation(std::span<const PluginContainer> plugins) {
+    std::lock_guard<std::mutex> lock(sSubscribersMutex);
+    for (const auto &plugin : plugins) {
+        const auto textSection = plugin.getPluginInformation().getSectionInfo(".text");
+        if (!textSection) {
+            continue;
+        }
+        for (auto &subscriber : sSubscribers) {
+            if (subscriber.device != INPUT_DEVICE_NONE && textSection->isInSection((uint32_t) subscriber.callback)) {
+                subscriber.enabled = plugin.isActive();
+            }
+        }
+    }
+}
+
+void InputSubscribers::DispatchVPAD(VPADChan chan, VPADStatus *buffer, uint32_t count) {
+    if (buffer == nullptr || count == 0 || (uint32_t) chan >= MAX_VPAD_CHANNELS) {
+        return;
+    }
+    std::array<PendingCall, MAX_INPUT_SUBSCRIBERS> calls;
+    uint32_t numberOfCalls = CollectCalls(INPUT_DEVICE_VPAD, calls);
+    if (numberOfCalls == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < numberOfCalls; i++) {
+        if (calls[i].type == WUPS_BACKEND_INPUT_SUBSCRIBER_FILTER) {
+            ((WUPSBackendVPADFilterFn) calls[i].callback)(chan, buffer, count, calls[i].context);
+        }
+    }
+    // The first entry holds the latest sample
+    VPADStatus snapshot = buffer[0];
+    for (uint32_t i = 0; i < numberOfCalls; i++) {
+        if (calls[i].type == WUPS_BACKEND_INPUT_SUBSCRIBER_OBSERVER) {
+            ((WUPSBackendVPADObserverFn) calls[i].callback)(chan, &snapshot, calls[i].context);
+        }
+    }
+}
+
+void InputSubscribers::DispatchWPAD(WPADChan chan, void *status) {
+    if (status == nullptr || (uint32_t) chan >= MAX_WPAD_CHANNELS) {
+        return;
+    }
+    std::array<PendingCall, MAX_INPUT_SUBSCRIBERS> calls;
+    uint32_t numberOfCalls = CollectCalls(INPUT_DEVICE_WPAD, calls);
+    if (numberOfCalls == 0) {
+        return;
+    }
+    // The size of the status depends on the data format, never touch more than WPADRead has written.
+    auto format   = WPADGetDataFormat(chan);
+    uint32_t size = GetWPADStatusSize(format);
+    for (uint32_t i = 0; i < numberOfCalls; i++) {
+        if (calls[i].type == WUPS_BACKEND_INPUT_SUBSCRIBER_FILTER) {
+            ((WUPSBackendWPADFilterFn) calls[i].callback)(chan, format, status, size, calls[i].context);
+        }
+    }
+    alignas(4) std::array<uint8_t, WPAD_MAX_STATUS_SIZE> snapshot;
+    memcpy(snapshot.data(), status, size);
+    for (uint32_t i = 0; i < numberOfCalls; i++) {
+        if (calls[i].type == WUPS_BACKEND_INPUT_SUBSCRIBER_OBSERVER) {
+            ((WUPSBackendWPADObserverFn) calls[i].callback)(chan, format, snapshot.data(), size, calls[i].context);
+        }
+    }
+}
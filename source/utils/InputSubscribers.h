@@ -0,0 +1,37 @@
+#pragma once
+
+#include "exports.h"
+#include "plugin/PluginContainer.h"
+#include <padscore/wpad.h>
+#include <span>
+#include <vpad/input.h>
+#include <wups_backend/import_defines.h>
+
+/**
+ * Lets plugins observe or filter VPAD/WPAD input via the backend's existing VPADRead/WPADRead replacements,
+ * instead of patching these functions themselves.
+ */
+namespace InputSubscribers {
+    PluginBackendApiErrorType AddVPADSubscriber(WUPSBackendInputSubscriberType type, void *callback, void *context, wups_backend_input_subscriber_handle *outHandle);
+
+    PluginBackendApiErrorType AddWPADSubscriber(WUPSBackendInputSubscriberType type, void *callback, void *context, wups_backend_input_subscriber_handle *outHandle);
+
+    PluginBackendApiErrorType RemoveSubscriber(wups_backend_input_subscriber_handle handle);
+
+    /**
+     * Removes all subscribers with a callback inside the .text section of one of the given plugins.
+     */
+    void RemoveSubscribersOfPlugins(std::span<const PluginContainer> plugins);
+
+    /**
+     * Disables the subscribers of plugins that are inactive for the current title, and enables the ones of active plugins.
+     */
+    void UpdateActivation(std::span<const PluginContainer> plugins);
+
+    void DispatchVPAD(VPADChan chan, VPADStatus *buffer, uint32_t count);
+
+    /**
+     * status must hold the data of the current data format of the channel, as returned by WPADRead.
+     */
+    void DispatchWPAD(WPADChan chan, void *status);
+} // namespace InputSubscribers
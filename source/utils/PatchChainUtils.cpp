@@ -0,0 +1,80 @@
+#include "PatchChainUtils.h"
+#include "logger.h"
+#include "patcher/hooks_patcher_static.h"
+#include <algorithm>
+#include <ranges>
+
+namespace {
+    struct PatchedFunction {
+        std::string_view name;
+        function_replacement_library_type_t library;
+        uint32_t physicalAddress;
+        // Order in which the patches have been added to the FunctionPatcher.
+        uint32_t patchSequence;
+        PatchChainEntry entry;
+    };
+
+    bool isSameFunction(const PatchChain &chain, const PatchedFunction &function) {
+        // Functions that are patched via address are identified by their address, everything else by library and name.
+        if (chain.physicalAddress != 0 || function.physicalAddress != 0) {
+            return chain.physicalAddress == function.physicalAddress;
+        }
+        return chain.library == function.library && chain.functionName == function.name;
+    }
+} // namespace
+
+std::vector<PatchChain> PatchChainUtils::buildPatchChains(std::span<const PluginContainer> plugins) {
+    std::vector<PatchedFunction> patches;
+    // The backend patches its functions before any plugin is loaded.
+    for (uint32_t i = 0; i < method_hooks_static_size; i++) {
+        const auto &cur = method_hooks_static[i];
+        patches.push_back({.name            = cur.ReplaceInRPL.function_name != nullptr ? cur.ReplaceInRPL.function_name : "",
+                           .library         = cur.ReplaceInRPL.library,
+                           .physicalAddress = cur.physicalAddr,
+                           .patchSequence   = 0,
+                           .entry           = {.plugin = nullptr, .replaceAddress = (const void *) cur.replaceAddr, .targetProcess = cur.targetProcess}});
+    }
+    for (const auto &plugin : plugins) {
+        for (const auto &function : plugin.getPluginInformation().getFunctionDataList()) {
+            // e.g. functions of inactive plugins.
+            if (function.getPatchSequence() == 0) {
+                continue;
+            }
+            patches.push_back({.name            = function.getName(),
+                               .library         = function.getLibrary(),
+                               .physicalAddress = (uint32_t) function.getPhysicalAddress(),
+                               .patchSequence   = function.getPatchSequence(),
+                               .entry           = {.plugin = &plugin, .replaceAddress = function.getReplaceAddress(), .targetProcess = function.getTargetProcess()}});
+        }
+    }
+    // The list order is not the patch order, e.g. a plugin that is activated again is patched after all plugins that stayed active.
+    std::ranges::stable_sort(patches, {}, &PatchedFunction::patchSequence);
+
+    std::vector<PatchChain> chains;
+    // The patch that has been added last is the first one to be called.
+    for (const auto &patch : std::ranges::reverse_view(patches)) {
+        auto chain = std::ranges::find_if(chains, [&patch](const auto &cur) { return isSameFunction(cur, patch); });
+        if (chain == chains.end()) {
+            chains.push_back({.functionName    = std::string(patch.name),
+                              .library         = patch.library,
+                              .physicalAddress = patch.physicalAddress,
+                              .entries         = {}});
+            chain = chains.end() - 1;
+        }
+        chain->entries.push_back(patch.entry);
+    }
+
+    return chains;
+}
+
+void PatchChainUtils::logPatchChains(std::span<const PatchChain> chains) {
+    for (const auto &chain : chains) {
+        if (chain.getNumberOfHops() < 2) {
+            continue;
+        }
+        DEBUG_FUNCTION_LINE("%s (lib: %d, PA: %08X) is replaced %d times:", chain.functionName.c_str(), chain.library, chain.physicalAddress, chain.getNumberOfHops());
+        for ([[maybe_unused]] const auto &entry : chain.entries) {
+            DEBUG_FUNCTION_LINE("    %08X %s", entry.replaceAddress, entry.plugin != nullptr ? entry.plugin->getMetaInformation().getName().c_str() : "<backend>");
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "plugin/PluginContainer.h"
+#include <function_patcher/fpatching_defines.h>
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+
+struct PatchChainEntry {
+    // nullptr if the function is replaced by the backend itself.
+    const PluginContainer *plugin;
+    const void *replaceAddress;
+    FunctionPatcherTargetProcess targetProcess;
+};
+
+/**
+ * All replacements of a single function, ordered by call order.
+ * The first entry is called first, the last entry calls the real function.
+ */
+struct PatchChain {
+    std::string functionName;
+    function_replacement_library_type_t library;
+    uint32_t physicalAddress;
+    std::vector<PatchChainEntry> entries;
+
+    [[nodiscard]] uint32_t getNumberOfHops() const {
+        return entries.size();
+    }
+
+    [[nodiscard]] bool isPatchedByBackend() const {
+        return std::ranges::any_of(entries, [](const auto &entry) { return entry.plugin == nullptr; });
+    }
+};
+
+class PatchChainUtils {
+public:
+    /**
+     * Builds the replacement chain of every function that is patched by the backend or by at least one of the given active plugins.
+     * Patches of the same function (same library and name, or same physical address) are collapsed into a single chain.
+     */
+    static std::vector<PatchChain> buildPatchChains(std::span<const PluginContainer> plugins);
+
+    static void logPatchChains(std::span<const PatchChain> chains);
+};
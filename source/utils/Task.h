@@ -0,0 +1,160 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+template<typename T>
+class Task;
+
+namespace TaskDetail {
+    struct PromiseBase {
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                // Continue with whoever is awaiting this task (symmetric transfer, no stack growth).
+                if (auto continuation = handle.promise().continuation) {
+                    return continuation;
+                }
+                return std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() noexcept {
+            return {};
+        }
+
+        void unhandled_exception() noexcept {
+            // We are building with -fno-exceptions, this is unreachable.
+            std::abort();
+        }
+
+        // Coroutine frames are allocated without throwing, a failed allocation results in an invalid Task.
+        static void *operator new(size_t size) noexcept {
+            return ::operator new(size, std::nothrow);
+        }
+
+        static void operator delete(void *ptr) noexcept {
+            ::operator delete(ptr);
+        }
+
+        std::coroutine_handle<> continuation;
+    };
+
+    template<typename T>
+    struct Promise : PromiseBase {
+        Task<T> get_return_object() noexcept;
+
+        static Task<T> get_return_object_on_allocation_failure() noexcept {
+            return {};
+        }
+
+        template<typename U>
+        void return_value(U &&value) {
+            result.emplace(std::forward<U>(value));
+        }
+
+        std::optional<T> result;
+    };
+
+    template<>
+    struct Promise<void> : PromiseBase {
+        Task<void> get_return_object() noexcept;
+
+        static Task<void> get_return_object_on_allocation_failure() noexcept;
+
+        void return_void() noexcept {}
+    };
+} // namespace TaskDetail
+
+/**
+ * Lazily started coroutine. The coroutine only starts running once the Task is awaited
+ * (or handed to TaskRuntime::Spawn / TaskRuntime::SyncWait) and resumes the awaiting coroutine when it's done.
+ *
+ * A Task can only be awaited once. If the coroutine frame could not be allocated, the Task is invalid
+ * and must not be awaited, check valid() before.
+ */
+template<typename T = void>
+class Task {
+public:
+    using promise_type = TaskDetail::Promise<T>;
+
+    Task() = default;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle) {
+    }
+
+    Task(const Task &) = delete;
+
+    Task(Task &&src) noexcept : mHandle(std::exchange(src.mHandle, nullptr)) {
+    }
+
+    Task &operator=(Task &&src) noexcept {
+        if (this != &src) {
+            destroy();
+            mHandle = std::exchange(src.mHandle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        destroy();
+    }
+
+    [[nodiscard]] bool valid() const {
+        return (bool) mHandle;
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        mHandle.promise().continuation = awaiting;
+        return mHandle;
+    }
+
+    T await_resume() noexcept {
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*mHandle.promise().result);
+        }
+    }
+
+private:
+    void destroy() {
+        if (mHandle) {
+            mHandle.destroy();
+            mHandle = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+namespace TaskDetail {
+    template<typename T>
+    Task<T> Promise<T>::get_return_object() noexcept {
+        return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> Promise<void>::get_return_object() noexcept {
+        return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+    }
+
+    inline Task<void> Promise<void>::get_return_object_on_allocation_failure() noexcept {
+        return {};
+    }
+} // namespace TaskDetail
@@ -0,0 +1,309 @@
+#include "TaskRuntime.h"
+#include "fs/FSUtils.h"
+#include "logger.h"
+#include "utils.h"
+#include <array>
+#include <deque>
+#include <mutex>
+
+#ifdef __WIIU__
+#include <coreinit/core.h>
+#include <coreinit/debug.h>
+#include <coreinit/thread.h>
+#else
+#include <functional>
+#include <thread>
+#endif
+
+#define CPU_WORKER_STACK_SIZE 0x10000
+#define IO_WORKER_STACK_SIZE  0x8000
+#define NUMBER_OF_CPU_WORKERS 3
+
+#ifdef __WIIU__
+#define IO_WORKER_AFFINITY OS_THREAD_ATTRIB_AFFINITY_ANY
+#else
+#define IO_WORKER_AFFINITY 0
+#endif
+
+namespace {
+#ifdef __WIIU__
+    class WorkerThread {
+    public:
+        bool create(int (*entry)(int, const char **), void *arg, uint32_t stackSize, uint32_t affinity, const char *name) {
+            mThread = make_unique_nothrow<OSThread>();
+            mStack  = make_unique_nothrow<uint8_t[]>((size_t) stackSize);
+            if (!mThread || !mStack) {
+                DEBUG_FUNCTION_LINE_ERR("Failed to allocate worker thread");
+                reset();
+                return false;
+            }
+            if (!OSCreateThread(mThread.get(), entry, 0, (char *) arg, mStack.get() + stackSize, stackSize,
+                                OSGetThreadPriority(OSGetCurrentThread()), (OSThreadAttributes) affinity)) {
+                DEBUG_FUNCTION_LINE_ERR("Failed to create worker thread %s", name);
+                reset();
+                return false;
+            }
+            OSSetThreadName(mThread.get(), name);
+            OSResumeThread(mThread.get());
+            return true;
+        }
+
+        void join() {
+            if (mThread) {
+                int res;
+                OSJoinThread(mThread.get(), &res);
+                reset();
+            }
+        }
+
+    private:
+        void reset() {
+            mThread.reset();
+            mStack.reset();
+        }
+
+        std::unique_ptr<OSThread> mThread;
+        std::unique_ptr<uint8_t[]> mStack;
+    };
+
+    uint32_t CurrentCore() {
+        return OSGetCoreId();
+    }
+#else
+    class WorkerThread {
+    public:
+        bool create(int (*entry)(int, const char **), void *arg, uint32_t, uint32_t, const char *) {
+            mThread = std::thread(entry, 0, (const char **) arg);
+            return true;
+        }
+
+        void join() {
+            if (mThread.joinable()) {
+                mThread.join();
+            }
+        }
+
+    private:
+        std::thread mThread;
+    };
+
+    uint32_t CurrentCore() {
+        return std::hash<std::thread::id>{}(std::this_thread::get_id());
+    }
+#endif
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::coroutine_handle<>> jobs;
+    };
+
+    struct Worker {
+        WorkQueue queue;
+        WorkerThread thread;
+        bool running = false;
+    };
+
+    std::array<Worker, NUMBER_OF_CPU_WORKERS> sCPUWorkers;
+    Worker sIOWorker;
+    TaskSemaphore sCPUJobs;
+    TaskSemaphore sIOJobs;
+
+    // Guards sRunning, so no job can be queued after Shutdown() has stopped the workers.
+    std::mutex sStateMutex;
+    bool sRunning = false;
+
+    std::coroutine_handle<> PopBack(WorkQueue &queue) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            return nullptr;
+        }
+        auto job = queue.jobs.back();
+        queue.jobs.pop_back();
+        return job;
+    }
+
+    std::coroutine_handle<> PopFront(WorkQueue &queue) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            return nullptr;
+        }
+        auto job = queue.jobs.front();
+        queue.jobs.pop_front();
+        return job;
+    }
+
+    /*
+     * Each queued job signals the semaphore once and every job is only taken after waiting for the semaphore,
+     * so a worker always finds a job after waking up, unless it has been woken up by Shutdown().
+     */
+    int CPUWorkerEntry(int, const char **argv) {
+        auto index = (uint32_t) (uintptr_t) argv;
+        while (true) {
+            sCPUJobs.wait();
+            // Newest job of our own queue first, the data it needs is most likely still in the cache.
+            auto job = PopBack(sCPUWorkers[index].queue);
+            // Steal the oldest job of the other workers.
+            for (uint32_t i = 1; !job && i < NUMBER_OF_CPU_WORKERS; i++) {
+                job = PopFront(sCPUWorkers[(index + i) % NUMBER_OF_CPU_WORKERS].queue);
+            }
+            if (!job) {
+                break;
+            }
+            job.resume();
+        }
+        return 0;
+    }
+
+    int IOWorkerEntry(int, const char **) {
+        while (true) {
+            sIOJobs.wait();
+            auto job = PopFront(sIOWorker.queue);
+            if (!job) {
+                break;
+            }
+            job.resume();
+        }
+        return 0;
+    }
+} // namespace
+
+#ifdef __WIIU__
+TaskSemaphore::TaskSemaphore(int32_t count) {
+    OSInitSemaphore(&mSemaphore, count);
+}
+
+void TaskSemaphore::signal() {
+    OSSignalSemaphore(&mSemaphore);
+}
+
+void TaskSemaphore::wait() {
+    OSWaitSemaphore(&mSemaphore);
+}
+#else
+TaskSemaphore::TaskSemaphore(int32_t count) : mSemaphore(count) {
+}
+
+void TaskSemaphore::signal() {
+    mSemaphore.release();
+}
+
+void TaskSemaphore::wait() {
+    mSemaphore.acquire();
+}
+#endif
+
+namespace {
+    void StopWorkers() {
+        // Every worker that doesn't find a job after waking up stops, remaining jobs are finished first.
+        for (auto &worker : sCPUWorkers) {
+            if (worker.running) {
+                sCPUJobs.signal();
+            }
+        }
+        if (sIOWorker.running) {
+            sIOJobs.signal();
+        }
+        for (auto &worker : sCPUWorkers) {
+            worker.thread.join();
+            worker.running = false;
+        }
+        sIOWorker.thread.join();
+        sIOWorker.running = false;
+    }
+} // namespace
+
+bool TaskRuntime::Start() {
+    std::lock_guard<std::mutex> lock(sStateMutex);
+    if (sRunning) {
+        return true;
+    }
+    bool anyCPUWorker = false;
+    for (uint32_t core = 0; core < NUMBER_OF_CPU_WORKERS; core++) {
+        auto &worker   = sCPUWorkers[core];
+        worker.running = worker.thread.create(&CPUWorkerEntry, (void *) (uintptr_t) core, CPU_WORKER_STACK_SIZE, 1 << core, "WUPSBackend TaskRuntime CPU");
+        anyCPUWorker |= worker.running;
+    }
+    sIOWorker.running = sIOWorker.thread.create(&IOWorkerEntry, nullptr, IO_WORKER_STACK_SIZE, IO_WORKER_AFFINITY, "WUPSBackend TaskRuntime IO");
+    if (!anyCPUWorker || !sIOWorker.running) {
+        DEBUG_FUNCTION_LINE_WARN("Failed to start the task runtime, tasks will be executed synchronously");
+        StopWorkers();
+        return false;
+    }
+    sRunning = true;
+    return true;
+}
+
+void TaskRuntime::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sStateMutex);
+        if (!sRunning) {
+            return;
+        }
+        sRunning = false;
+    }
+    StopWorkers();
+}
+
+bool TaskRuntime::IsRunning() {
+    std::lock_guard<std::mutex> lock(sStateMutex);
+    return sRunning;
+}
+
+bool TaskRuntime::Enqueue(std::coroutine_handle<> handle, TaskQueue queue) {
+    std::lock_guard<std::mutex> lock(sStateMutex);
+    if (!sRunning) {
+        return false;
+    }
+    if (queue == TaskQueue::IO) {
+        {
+            std::lock_guard<std::mutex> queueLock(sIOWorker.queue.mutex);
+            sIOWorker.queue.jobs.push_back(handle);
+        }
+        sIOJobs.signal();
+        return true;
+    }
+    // Queue the job on the current core, it's stolen by another worker if that one is busy.
+    auto &worker = sCPUWorkers[CurrentCore() % NUMBER_OF_CPU_WORKERS];
+    {
+        std::lock_guard<std::mutex> queueLock(worker.queue.mutex);
+        worker.queue.jobs.push_back(handle);
+    }
+    sCPUJobs.signal();
+    return true;
+}
+
+Task<std::optional<std::vector<uint8_t>>> TaskRuntime::ReadFile(std::string path) {
+    co_await ScheduleIO();
+    std::vector<uint8_t> buffer;
+    int32_t res = FSUtils::LoadFileToMem(path, buffer);
+    // Don't block the I/O thread with whatever the caller does with the data.
+    co_await Schedule();
+    if (res < 0) {
+        DEBUG_FUNCTION_LINE_WARN("Failed to read %s: %d", path.c_str(), res);
+        co_return std::nullopt;
+    }
+    co_return std::move(buffer);
+}
+
+namespace {
+    TaskRuntime::Detail::DetachedTask RunDetached(Task<> task) {
+        co_await TaskRuntime::Schedule();
+        co_await task;
+    }
+} // namespace
+
+bool TaskRuntime::Spawn(Task<> task) {
+    if (!task.valid()) {
+        return false;
+    }
+    return RunDetached(std::move(task)).started;
+}
+
+void TaskRuntime::Detail::Fatal(const char *message) {
+#ifdef __WIIU__
+    OSFatal(message);
+#else
+    DEBUG_FUNCTION_LINE_ERR("%s", message);
+    std::abort();
+#endif
+}
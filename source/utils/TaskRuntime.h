@@ -0,0 +1,185 @@
+#pragma once
+
+#include "Task.h"
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef __WIIU__
+#include <coreinit/semaphore.h>
+#else
+#include <semaphore>
+#endif
+
+class TaskSemaphore {
+public:
+    explicit TaskSemaphore(int32_t count = 0);
+
+    TaskSemaphore(const TaskSemaphore &) = delete;
+
+    void signal();
+
+    void wait();
+
+private:
+#ifdef __WIIU__
+    OSSemaphore mSemaphore{};
+#else
+    std::counting_semaphore<> mSemaphore;
+#endif
+};
+
+enum class TaskQueue {
+    // One worker thread per core, idle workers steal work from the other cores.
+    CPU,
+    // A single thread that does all blocking file system access, so SD card access is never interleaved.
+    IO,
+};
+
+/**
+ * Small coroutine runtime for backend work, see Task.h.
+ *
+ * Coroutines move between threads by awaiting Schedule() or ScheduleIO():
+ *
+ *     Task<> loadSomething() {
+ *         auto data = co_await TaskRuntime::ReadFile(path); // reads on the I/O thread
+ *         parse(*data);                                     // continues on a CPU worker
+ *     }
+ *
+ * If the runtime is not running (or the worker threads could not be created), awaiting Schedule()
+ * doesn't suspend and everything runs on the calling thread.
+ */
+namespace TaskRuntime {
+    /**
+     * Creates the worker threads. Must be called from the thread that calls Shutdown().
+     */
+    bool Start();
+
+    /**
+     * Waits until all scheduled work has been finished and stops the worker threads.
+     */
+    void Shutdown();
+
+    bool IsRunning();
+
+    /**
+     * Queues a suspended coroutine.
+     * @return false if the runtime is not running. The coroutine needs to be resumed by the caller then.
+     */
+    bool Enqueue(std::coroutine_handle<> handle, TaskQueue queue);
+
+    struct ScheduleAwaiter {
+        TaskQueue queue;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) const noexcept {
+            return Enqueue(handle, queue);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * Continues the current coroutine on a CPU worker.
+     */
+    inline ScheduleAwaiter Schedule() {
+        return {TaskQueue::CPU};
+    }
+
+    /**
+     * Continues the current coroutine on the I/O thread. Only blocking file system access should be done there.
+     */
+    inline ScheduleAwaiter ScheduleIO() {
+        return {TaskQueue::IO};
+    }
+
+    /**
+     * Runs fn on a CPU worker.
+     */
+    template<typename Fn>
+    Task<std::invoke_result_t<Fn>> Run(Fn fn) {
+        co_await Schedule();
+        co_return fn();
+    }
+
+    /**
+     * Reads a whole file on the I/O thread, the awaiting coroutine is continued on a CPU worker.
+     * @return std::nullopt if the file could not be read.
+     */
+    Task<std::optional<std::vector<uint8_t>>> ReadFile(std::string path);
+
+    /**
+     * Runs a task on a CPU worker without waiting for it. The task must not reference anything owned by the caller.
+     * @return false if the task could not be started.
+     */
+    bool Spawn(Task<> task);
+
+    namespace Detail {
+        struct DetachedTask {
+            struct promise_type {
+                DetachedTask get_return_object() noexcept {
+                    return {.started = true};
+                }
+
+                static DetachedTask get_return_object_on_allocation_failure() noexcept {
+                    return {.started = false};
+                }
+
+                std::suspend_never initial_suspend() noexcept {
+                    return {};
+                }
+
+                std::suspend_never final_suspend() noexcept {
+                    return {};
+                }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept {
+                    std::abort();
+                }
+
+                static void *operator new(size_t size) noexcept {
+                    return ::operator new(size, std::nothrow);
+                }
+
+                static void operator delete(void *ptr) noexcept {
+                    ::operator delete(ptr);
+                }
+            };
+
+            bool started;
+        };
+
+        template<typename T>
+        DetachedTask SignalWhenDone(Task<T> &task, TaskSemaphore &done) {
+            co_await task;
+            done.signal();
+        }
+
+        [[noreturn]] void Fatal(const char *message);
+    } // namespace Detail
+
+    /**
+     * Runs a task and blocks the calling thread until it has finished.
+     * Must not be called from a worker thread, the task might need that worker to make progress.
+     */
+    template<typename T>
+    T SyncWait(Task<T> task) {
+        if (!task.valid()) {
+            Detail::Fatal("TaskRuntime::SyncWait: invalid task");
+        }
+        TaskSemaphore done;
+        if (!Detail::SignalWhenDone(task, done).started) {
+            Detail::Fatal("TaskRuntime::SyncWait: failed to allocate coroutine");
+        }
+        done.wait();
+        return task.await_resume();
+    }
+} // namespace TaskRuntime
@@ -6,6 +6,7 @@
 #include "ConfigRenderer.h"
 #include "config/WUPSConfigAPI.h"
 #include "hooks.h"
+#include "plugin/PluginRegistry.h"
 #include "utils/input/CombinedInput.h"
 #include "utils/input/VPADInput.h"
 #include "utils/input/WPADInput.h"
@@ -74,8 +75,12 @@ WUPS_CONFIG_SIMPLE_INPUT ConfigUtils::convertInputs(uint32_t buttons) {
 void ConfigUtils::displayMenu() {
     renderBasicScreen("Loading configs...");
 
+    PluginRegistry::ReadGuard registry;
     std::vector<ConfigDisplayItem> configs;
-    for (const auto &plugin : gLoadedPlugins) {
+    for (const auto &plugin : registry->plugins) {
+        if (!plugin.isActive()) {
+            continue;
+        }
         GeneralConfigInformation info;
         info.name    = plugin.getMetaInformation().getName();
         info.author  = plugin.getMetaInformation().getAuthor();
@@ -217,7 +222,10 @@ void ConfigUtils::displayMenu() {
     startTime = OSGetTime();
     renderBasicScreen("Saving configs...");
 
-    for (const auto &plugin : gLoadedPlugins) {
+    for (const auto &plugin : registry->plugins) {
+        if (!plugin.isActive()) {
+            continue;
+        }
         const auto configData = plugin.getConfigData();
         if (configData) {
             if (configData->CallMenuClosedCallback() == WUPSCONFIG_API_RESULT_MISSING_CALLBACK) {
@@ -2,6 +2,13 @@
 #include "../globals.h"
 #include "../plugin/PluginDataFactory.h"
 #include "../plugin/PluginMetaInformationFactory.h"
+#include "../plugin/PluginPreparation.h"
+#include "../plugin/PluginRegistry.h"
+#include "FrameCallbacks.h"
+#include "InputSubscribers.h"
+#include "PatchChainUtils.h"
+#include "exports.h"
+#include "storage/StorageUtils.h"
 #include "utils.h"
 #include <wums.h>
 #include <wups_backend/import_defines.h>
@@ -23,14 +30,16 @@ extern "C" PluginBackendApiErrorType WUPSLoadAndLinkByDataHandle(const wups_back
         return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
     }
 
+    PluginPreparation::WaitUntilDone();
     std::lock_guard<std::mutex> lock(gLoadedDataMutex);
+    std::set<std::shared_ptr<PluginData>> pluginDataToLoad;
     for (uint32_t i = 0; i < plugin_data_handle_list_size; i++) {
         auto handle = plugin_data_handle_list[i];
         bool found  = false;
 
         for (const auto &pluginData : gLoadedData) {
             if (pluginData->getHandle() == handle) {
-                gLoadOnNextLaunch.insert(pluginData);
+                pluginDataToLoad.insert(pluginData);
                 found = true;
                 break;
             }
@@ -41,6 +50,14 @@ extern "C" PluginBackendApiErrorType WUPSLoadAndLinkByDataHandle(const wups_back
         }
     }
 
+    // Nothing changes if one of the plugins is invalid.
+    if (auto res = PluginPreparation::Validate(pluginDataToLoad); res != PLUGIN_BACKEND_API_ERROR_NONE) {
+        return res;
+    }
+    gLoadOnNextLaunch.insert(pluginDataToLoad.begin(), pluginDataToLoad.end());
+
+    // Do as much work as possible now instead of delaying the next launch.
+    PluginPreparation::Start(gLoadOnNextLaunch);
     return PLUGIN_BACKEND_API_ERROR_NONE;
 }
 
@@ -158,11 +175,13 @@ extern "C" PluginBackendApiErrorType WUPSGetPluginDataForContainerHandles(const
         return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
     }
 
+    // Publish() waits for readers while the mutex is held, so the mutex has to be taken first.
     std::lock_guard<std::mutex> lock(gLoadedDataMutex);
+    PluginRegistry::ReadGuard registry;
     for (uint32_t i = 0; i < buffer_size; i++) {
         auto handle = plugin_container_handle_list[i];
         bool found  = false;
-        for (const auto &curContainer : gLoadedPlugins) {
+        for (const auto &curContainer : registry->plugins) {
             if (curContainer.getHandle() == handle) {
                 auto pluginData     = curContainer.getPluginDataCopy();
                 plugin_data_list[i] = (uint32_t) pluginData->getHandle();
@@ -183,10 +202,11 @@ extern "C" PluginBackendApiErrorType WUPSGetPluginDataForContainerHandles(const
 extern "C" PluginBackendApiErrorType WUPSGetMetaInformation(const wups_backend_plugin_container_handle *plugin_container_handle_list, wups_backend_plugin_information *plugin_information_list, uint32_t buffer_size) {
     PluginBackendApiErrorType res = PLUGIN_BACKEND_API_ERROR_NONE;
     if (plugin_container_handle_list != nullptr && buffer_size != 0) {
+        PluginRegistry::ReadGuard registry;
         for (uint32_t i = 0; i < buffer_size; i++) {
             auto handle = plugin_container_handle_list[i];
             bool found  = false;
-            for (const auto &curContainer : gLoadedPlugins) {
+            for (const auto &curContainer : registry->plugins) {
                 if (curContainer.getHandle() == handle) {
                     const auto &metaInfo = curContainer.getMetaInformation();
 
@@ -221,7 +241,8 @@ extern "C" PluginBackendApiErrorType WUPSGetLoadedPlugins(wups_backend_plugin_co
     }
     *plugin_information_version = WUPS_BACKEND_PLUGIN_INFORMATION_VERSION;
     uint32_t counter            = 0;
-    for (const auto &plugin : gLoadedPlugins) {
+    PluginRegistry::ReadGuard registry;
+    for (const auto &plugin : registry->plugins) {
         if (counter < buffer_size) {
             io_handles[counter] = plugin.getHandle();
             counter++;
@@ -252,7 +273,7 @@ extern "C" PluginBackendApiErrorType WUPSGetAPIVersion(WUPSBackendAPIVersion *ou
     if (outVersion == nullptr) {
         return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
     }
-    *outVersion = 3;
+    *outVersion = 4;
     return PLUGIN_BACKEND_API_ERROR_NONE;
 }
 
@@ -260,7 +281,8 @@ extern "C" PluginBackendApiErrorType WUPSGetNumberOfLoadedPlugins(uint32_t *outC
     if (outCount == nullptr) {
         return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
     }
-    *outCount = gLoadedPlugins.size();
+    PluginRegistry::ReadGuard registry;
+    *outCount = registry->plugins.size();
     return PLUGIN_BACKEND_API_ERROR_NONE;
 }
 
@@ -271,7 +293,8 @@ extern "C" PluginBackendApiErrorType WUPSGetSectionInformationForPlugin(const wu
     }
     if (handle != 0 && plugin_section_list != nullptr && buffer_size != 0) {
         bool found = false;
-        for (const auto &curContainer : gLoadedPlugins) {
+        PluginRegistry::ReadGuard registry;
+        for (const auto &curContainer : registry->plugins) {
             if (curContainer.getHandle() == handle) {
                 found                       = true;
                 const auto &sectionInfoList = curContainer.getPluginInformation().getSectionInfoList();
@@ -315,7 +338,8 @@ extern "C" PluginBackendApiErrorType WUPSGetSectionMemoryAddresses(wups_backend_
     if (handle == 0 || textAddress == nullptr || dataAddress == nullptr) {
         return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
     }
-    for (const auto &curContainer : gLoadedPlugins) {
+    PluginRegistry::ReadGuard registry;
+    for (const auto &curContainer : registry->plugins) {
         if (curContainer.getHandle() == handle) {
             *textAddress = (void *) curContainer.getPluginInformation().getTextMemory().data();
             *dataAddress = (void *) curContainer.getPluginInformation().getDataMemory().data();
@@ -342,3 +366,123 @@ extern "C" PluginBackendApiErrorType WUPSGetPluginMetaInformationByBufferEx(wups
 
 WUMS_EXPORT_FUNCTION(WUPSGetPluginMetaInformationByPathEx);
 WUMS_EXPORT_FUNCTION(WUPSGetPluginMetaInformationByBufferEx);
+
+
+// API 4.0
+extern "C" PluginBackendApiErrorType WUPSGetFunctionPatchChains(wups_backend_function_patch_chain_info *chain_info_list, uint32_t buffer_size, uint32_t *out_count) {
+    if (out_count == nullptr || (chain_info_list == nullptr && buffer_size != 0)) {
+        return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
+    }
+
+    PluginRegistry::ReadGuard registry;
+    auto chains = PatchChainUtils::buildPatchChains(registry->plugins);
+
+    uint32_t offset = 0;
+    for (const auto &chain : chains) {
+        if (offset >= buffer_size) {
+            break;
+        }
+        auto &cur = chain_info_list[offset];
+        memset(&cur, 0, sizeof(cur));
+        cur.function_patch_chain_info_version = WUPS_BACKEND_FUNCTION_PATCH_CHAIN_INFORMATION_VERSION;
+        strncpy(cur.functionName, chain.functionName.c_str(), sizeof(cur.functionName) - 1);
+        cur.library          = chain.library;
+        cur.physicalAddress  = chain.physicalAddress;
+        cur.numberOfHops     = chain.getNumberOfHops();
+        cur.patchedByBackend = chain.isPatchedByBackend();
+        for (const auto &entry : chain.entries) {
+            if (entry.plugin == nullptr || cur.numberOfPlugins >= WUPS_BACKEND_FUNCTION_PATCH_CHAIN_MAX_PLUGINS) {
+                continue;
+            }
+            cur.plugins[cur.numberOfPlugins++] = entry.plugin->getHandle();
+        }
+        offset++;
+    }
+    *out_count = offset;
+
+    return PLUGIN_BACKEND_API_ERROR_NONE;
+}
+
+extern "C" PluginBackendApiErrorType WUPSGetHookTimingStats(wups_backend_hook_timing_info *timing_info_list, uint32_t buffer_size, uint32_t *out_count) {
+    if (out_count == nullptr || (timing_info_list == nullptr && buffer_size != 0)) {
+        return PLUGIN_BACKEND_API_ERROR_INVALID_ARG;
+    }
+
+    PluginRegistry::ReadGuard registry;
+    uint32_t offset = 0;
+    for (const auto &plugin : registry->plugins) {
+        for (uint32_t type = 0; type < WUPS_LOADER_HOOK_TYPE_COUNT; type++) {
+            const auto stats = plugin.getHookTimingStats((wups_loader_hook_type_t) type);
+            if (stats.count == 0) {
+                continue;
+            }
+            if (offset >= buffer_size) {
+                break;
+            }
+            auto &cur                    = timing_info_list[offset];
+            cur.hook_timing_info_version = WUPS_BACKEND_HOOK_TIMING_INFORMATION_VERSION;
+            cur.plugin                   = plugin.getHandle();
+            cur.hookType                 = type;
+            cur.count                    = stats.count;
+            cur.overBudgetCount          = stats.overBudgetCount;
+            cur.lastInMicroseconds       = OSTicksToMicroseconds(stats.last);
+            cur.maxInMicroseconds        = OSTicksToMicroseconds(stats.max);
+            cur.totalInMicroseconds      = OSTicksToMicroseconds(stats.total);
+            offset++;
+        }
+    }
+    *out_count = offset;
+
+    return PLUGIN_BACKEND_API_ERROR_NONE;
+}
+
+extern "C" PluginBackendApiErrorType WUPSSetHookTimeBudget(uint32_t budget_in_us) {
+    gHookTimeBudgetInMicroseconds = budget_in_us;
+    return PLUGIN_BACKEND_API_ERROR_NONE;
+}
+
+extern "C" PluginBackendApiErrorType WUPSSetFrameCallbackBudget(uint32_t budget_in_us) {
+    gFrameCallbackBudgetInMicroseconds = budget_in_us;
+    return PLUGIN_BACKEND_API_ERROR_NONE;
+}
+
+extern "C" PluginBackendApiErrorType WUPSSetStorageJSONExport(bool enabled) {
+    StorageUtils::API::Internal::SetJSONExport(enabled);
+    return PLUGIN_BACKEND_API_ERROR_NONE;
+}
+
+extern "C" PluginBackendApiErrorType WUPSAddVPADInputSubscriber(WUPSBackendInputSubscriberType type, void *callback, void *context, wups_backend_input_subscriber_handle *outHandle) {
+    return InputSubscribers::AddVPADSubscriber(type, callback, context, outHandle);
+}
+
+extern "C" PluginBackendApiErrorType WUPSAddWPADInputSubscriber(WUPSBackendInputSubscriberType type, void *callback, void *context, wups_backend_input_subscriber_handle *outHandle) {
+    return InputSubscribers::AddWPADSubscriber(type, callback, context, outHandle);
+}
+
+extern "C" PluginBackendApiErrorType WUPSRemoveInputSubscriber(wups_backend_input_subscriber_handle handle) {
+    return InputSubscribers::RemoveSubscriber(handle);
+}
+
+extern "C" PluginBackendApiErrorType WUPSAddFrameCallback(WUPSBackendFrameCallbackFn callback, void *context, wups_backend_frame_callback_handle *outHandle) {
+    return FrameCallbacks::AddCallback(callback, context, outHandle);
+}
+
+extern "C" PluginBackendApiErrorType WUPSRemoveFrameCallback(wups_backend_frame_callback_handle handle) {
+    return FrameCallbacks::RemoveCallback(handle);
+}
+
+extern "C" PluginBackendApiErrorType WUPSGetFrameCallbackTimingStats(wups_backend_frame_callback_timing_info *timing_info_list, uint32_t buffer_size, uint32_t *out_count) {
+    return FrameCallbacks::GetTimingStats(timing_info_list, buffer_size, out_count);
+}
+
+WUMS_EXPORT_FUNCTION(WUPSGetFunctionPatchChains);
+WUMS_EXPORT_FUNCTION(WUPSGetHookTimingStats);
+WUMS_EXPORT_FUNCTION(WUPSSetHookTimeBudget);
+WUMS_EXPORT_FUNCTION(WUPSSetFrameCallbackBudget);
+WUMS_EXPORT_FUNCTION(WUPSSetStorageJSONExport);
+WUMS_EXPORT_FUNCTION(WUPSAddVPADInputSubscriber);
+WUMS_EXPORT_FUNCTION(WUPSAddWPADInputSubscriber);
+WUMS_EXPORT_FUNCTION(WUPSRemoveInputSubscriber);
+WUMS_EXPORT_FUNCTION(WUPSAddFrameCallback);
+WUMS_EXPORT_FUNCTION(WUPSRemoveFrameCallback);
+WUMS_EXPORT_FUNCTION(WUPSGetFrameCallbackTimingStats);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <padscore/wpad.h>
+#include <vpad/input.h>
+#include <wups_backend/import_defines.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WUPS_BACKEND_FUNCTION_PATCH_CHAIN_INFORMATION_VERSION 0x00000001
+#define WUPS_BACKEND_FUNCTION_PATCH_CHAIN_MAX_PLUGINS         16
+
+typedef struct wups_backend_function_patch_chain_info {
+    uint32_t function_patch_chain_info_version;
+    char functionName[0x40];
+    uint32_t library;
+    uint32_t physicalAddress;
+    // Number of replacements that are executed on each call of the function.
+    uint32_t numberOfHops;
+    bool patchedByBackend;
+    // Plugins replacing this function in call order. Only the first WUPS_BACKEND_FUNCTION_PATCH_CHAIN_MAX_PLUGINS are listed.
+    uint32_t numberOfPlugins;
+    wups_backend_plugin_container_handle plugins[WUPS_BACKEND_FUNCTION_PATCH_CHAIN_MAX_PLUGINS];
+} wups_backend_function_patch_chain_info;
+
+#define WUPS_BACKEND_HOOK_TIMING_INFORMATION_VERSION 0x00000001
+
+typedef struct wups_backend_hook_timing_info {
+    uint32_t hook_timing_info_version;
+    wups_backend_plugin_container_handle plugin;
+    // wups_loader_hook_type_t
+    uint32_t hookType;
+    uint32_t count;
+    // Number of calls that took longer than the budget set via WUPSSetHookTimeBudget.
+    uint32_t overBudgetCount;
+    uint64_t lastInMicroseconds;
+    uint64_t maxInMicroseconds;
+    uint64_t totalInMicroseconds;
+} wups_backend_hook_timing_info;
+
+typedef enum WUPSBackendInputSubscriberType {
+    // Is called with a read-only snapshot of the latest sample, after all filters have been applied.
+    WUPS_BACKEND_INPUT_SUBSCRIBER_OBSERVER = 0,
+    // Is called with the buffer that will be returned to the caller and may modify it.
+    WUPS_BACKEND_INPUT_SUBSCRIBER_FILTER = 1,
+} WUPSBackendInputSubscriberType;
+
+typedef uint32_t wups_backend_input_subscriber_handle;
+
+typedef void (*WUPSBackendVPADObserverFn)(VPADChan chan, const VPADStatus *status, void *context);
+typedef void (*WUPSBackendVPADFilterFn)(VPADChan chan, VPADStatus *buffer, uint32_t count, void *context);
+// status points to the struct of the data format of the channel (e.g. WPADStatusProController for WPAD_FMT_PRO_CONTROLLER), size is its size in bytes.
+typedef void (*WUPSBackendWPADObserverFn)(WPADChan chan, WPADDataFormat format, const void *status, uint32_t size, void *context);
+typedef void (*WUPSBackendWPADFilterFn)(WPADChan chan, WPADDataFormat format, void *status, uint32_t size, void *context);
+
+typedef uint32_t wups_backend_frame_callback_handle;
+
+typedef void (*WUPSBackendFrameCallbackFn)(void *context);
+
+#define WUPS_BACKEND_FRAME_CALLBACK_TIMING_INFORMATION_VERSION 0x00000001
+
+typedef struct wups_backend_frame_callback_timing_info {
+    uint32_t frame_callback_timing_info_version;
+    wups_backend_frame_callback_handle handle;
+    // Plugin that provides the callback, 0 if it doesn't belong to a loaded plugin.
+    wups_backend_plugin_container_handle plugin;
+    uint32_t count;
+    // Number of calls that took longer than the budget set via WUPSSetHookTimeBudget.
+    uint32_t overBudgetCount;
+    uint64_t lastInMicroseconds;
+    uint64_t maxInMicroseconds;
+    uint64_t totalInMicroseconds;
+} wups_backend_frame_callback_timing_info;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,36 @@
+#include "StorageArena.h"
+#include <algorithm>
+
+namespace {
+    // Most storages only consist of a few small items, the chunks of a pool grow with the number of allocations.
+    constexpr std::pmr::pool_options POOL_OPTIONS = {.max_blocks_per_chunk = 64, .largest_required_pool_block = 0x200};
+} // namespace
+
+StorageArena::StorageArena() : mPool(POOL_OPTIONS, &mHeap) {
+}
+
+StorageArena::~StorageArena() = default;
+
+void *StorageArena::do_allocate(size_t bytes, size_t alignment) {
+    auto res = mPool.allocate(bytes, alignment);
+    mUsedBytes += bytes;
+    mPeakUsedBytes = std::max(mPeakUsedBytes, mUsedBytes);
+    return res;
+}
+
+void StorageArena::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    mPool.deallocate(p, bytes, alignment);
+    mUsedBytes -= bytes;
+}
+
+void *StorageArena::HeapResource::do_allocate(size_t bytes, size_t alignment) {
+    auto res = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    reservedBytes += bytes;
+    numberOfAllocations++;
+    return res;
+}
+
+void StorageArena::HeapResource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    reservedBytes -= bytes;
+}
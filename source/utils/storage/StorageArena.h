@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+/**
+ * Memory resource that holds everything of one storage tree: the nodes, keys and values.
+ *
+ * Small allocations are served from pools that take larger chunks from the heap, so a storage with many items
+ * needs only a few heap allocations. Memory of deleted items is reused by the pools, all chunks are returned to
+ * the heap together when the arena is destroyed.
+ *
+ * Not thread safe, a tree is only used by one thread at a time.
+ */
+class StorageArena : public std::pmr::memory_resource {
+public:
+    StorageArena();
+
+    StorageArena(const StorageArena &) = delete;
+
+    ~StorageArena() override;
+
+    /**
+     * Bytes that are currently allocated by the tree.
+     */
+    [[nodiscard]] size_t getUsedBytes() const {
+        return mUsedBytes;
+    }
+
+    [[nodiscard]] size_t getPeakUsedBytes() const {
+        return mPeakUsedBytes;
+    }
+
+    /**
+     * Bytes the arena has taken from the heap, including the bookkeeping of the pools.
+     */
+    [[nodiscard]] size_t getReservedBytes() const {
+        return mHeap.reservedBytes;
+    }
+
+    /**
+     * Number of chunks the arena has taken from the heap so far.
+     */
+    [[nodiscard]] uint32_t getNumberOfHeapAllocations() const {
+        return mHeap.numberOfAllocations;
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    /**
+     * Counts the chunks the pools take from the heap.
+     */
+    class HeapResource : public std::pmr::memory_resource {
+    public:
+        size_t reservedBytes         = 0;
+        uint32_t numberOfAllocations = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    HeapResource mHeap;
+    std::pmr::unsynchronized_pool_resource mPool;
+    size_t mUsedBytes     = 0;
+    size_t mPeakUsedBytes = 0;
+};
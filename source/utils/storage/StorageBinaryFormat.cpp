@@ -0,0 +1,255 @@
+#include "StorageBinaryFormat.h"
+#include "utils/logger.h"
+#include <bit>
+#include <cstring>
+#include <string>
+
+namespace {
+    constexpr uint8_t MAGIC[4]           = {'W', 'S', 'T', 'G'};
+    constexpr uint32_t VERSION           = 1;
+    constexpr size_t HEADER_SIZE         = sizeof(MAGIC) + sizeof(uint32_t);
+    constexpr size_t ENTRY_HEADER_SIZE   = sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint32_t);
+    constexpr size_t ENTRY_LENGTH_OFFSET = sizeof(uint8_t) + sizeof(uint16_t);
+    // Sub items are deserialized recursively, a corrupted file must not be able to exhaust the stack.
+    constexpr uint32_t MAX_DEPTH = 64;
+
+    void Put16(uint8_t *data, uint16_t value) {
+        data[0] = value >> 8;
+        data[1] = value;
+    }
+
+    void Put32(uint8_t *data, uint32_t value) {
+        Put16(data, value >> 16);
+        Put16(data + 2, value);
+    }
+
+    void Put64(uint8_t *data, uint64_t value) {
+        Put32(data, value >> 32);
+        Put32(data + 4, value);
+    }
+
+    uint16_t Get16(const uint8_t *data) {
+        return (data[0] << 8) | data[1];
+    }
+
+    uint32_t Get32(const uint8_t *data) {
+        return ((uint32_t) Get16(data) << 16) | Get16(data + 2);
+    }
+
+    uint64_t Get64(const uint8_t *data) {
+        return ((uint64_t) Get32(data) << 32) | Get32(data + 4);
+    }
+
+    uint64_t ValueSize(const StorageItem &item) {
+        uint32_t size = 0;
+        switch (item.getType()) {
+            case StorageItemType::String:
+                // Includes the null terminator.
+                item.getItemSizeString(size);
+                return size - 1;
+            case StorageItemType::Binary:
+                item.getItemSizeBinary(size);
+                return size;
+            case StorageItemType::Boolean:
+                return 1;
+            case StorageItemType::S64:
+            case StorageItemType::U64:
+            case StorageItemType::Double:
+                return sizeof(uint64_t);
+            case StorageItemType::None:
+                break;
+        }
+        return 0;
+    }
+
+    /**
+     * The length of every entry is written before its value, so the size of a sub item is calculated before it's written.
+     */
+    uint64_t EntriesSize(const StorageSubItem &item) {
+        uint64_t size = 0;
+        for (const auto &[key, child] : item.getChildren()) {
+            if (auto subItem = std::get_if<StorageNodePtr<StorageSubItem>>(&child)) {
+                size += ENTRY_HEADER_SIZE + key.size() + EntriesSize(**subItem);
+            } else if (const auto &value = *std::get<StorageNodePtr<StorageItem>>(child); value.getType() != StorageItemType::None) {
+                size += ENTRY_HEADER_SIZE + key.size() + ValueSize(value);
+            }
+        }
+        return size;
+    }
+
+    bool WriteEntryHeader(BufferedFileWriter &out, StorageBinaryFormat::EntryType type, std::string_view key, uint64_t valueLength) {
+        if (key.size() > UINT16_MAX || valueLength > UINT32_MAX) {
+            DEBUG_FUNCTION_LINE_WARN("Entry %.*s is too big", (int) key.size(), key.data());
+            return false;
+        }
+        uint8_t header[ENTRY_HEADER_SIZE];
+        header[0] = type;
+        Put16(&header[1], key.size());
+        Put32(&header[ENTRY_LENGTH_OFFSET], valueLength);
+        return out.write(header, sizeof(header)) && out.write(key);
+    }
+
+    bool Write64(BufferedFileWriter &out, uint64_t value) {
+        uint8_t data[sizeof(uint64_t)];
+        Put64(data, value);
+        return out.write(data, sizeof(data));
+    }
+
+    bool SerializeItem(std::string_view key, const StorageItem &item, BufferedFileWriter &out) {
+        switch (item.getType()) {
+            case StorageItemType::String: {
+                std::string_view res;
+                return item.getValue(res) &&
+                       WriteEntryHeader(out, StorageBinaryFormat::ENTRY_TYPE_STRING, key, res.size()) &&
+                       out.write(res);
+            }
+            case StorageItemType::Boolean: {
+                bool res;
+                return item.getValue(res) &&
+                       WriteEntryHeader(out, StorageBinaryFormat::ENTRY_TYPE_BOOLEAN, key, 1) &&
+                       out.put(res ? 1 : 0);
+            }
+            case StorageItemType::S64: {
+                int64_t res;
+                return item.getValue(res) &&
+                       WriteEntryHeader(out, StorageBinaryFormat::ENTRY_TYPE_S64, key, sizeof(uint64_t)) &&
+                       Write64(out, (uint64_t) res);
+            }
+            case StorageItemType::U64: {
+                uint64_t res;
+                return item.getValue(res) &&
+                       WriteEntryHeader(out, StorageBinaryFormat::ENTRY_TYPE_U64, key, sizeof(uint64_t)) &&
+                       Write64(out, res);
+            }
+            case StorageItemType::Double: {
+                double res;
+                return item.getValue(res) &&
+                       WriteEntryHeader(out, StorageBinaryFormat::ENTRY_TYPE_DOUBLE, key, sizeof(uint64_t)) &&
+                       Write64(out, std::bit_cast<uint64_t>(res));
+            }
+            case StorageItemType::Binary: {
+                std::span<const uint8_t> res;
+                return item.getValue(res) &&
+                       WriteEntryHeader(out, StorageBinaryFormat::ENTRY_TYPE_BINARY, key, res.size()) &&
+                       out.write(res.data(), res.size());
+            }
+            case StorageItemType::None:
+                DEBUG_FUNCTION_LINE_WARN("Skip: StorageItemType::None");
+                return true;
+        }
+        return false;
+    }
+
+    bool SerializeEntries(const StorageSubItem &item, BufferedFileWriter &out) {
+        for (const auto &[key, child] : item.getChildren()) {
+            if (auto subItem = std::get_if<StorageNodePtr<StorageSubItem>>(&child)) {
+                if (!WriteEntryHeader(out, StorageBinaryFormat::ENTRY_TYPE_SUB_ITEM, key, EntriesSize(**subItem)) ||
+                    !SerializeEntries(**subItem, out)) {
+                    return false;
+                }
+            } else if (!SerializeItem(key, *std::get<StorageNodePtr<StorageItem>>(child), out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool DeserializeEntries(std::span<const uint8_t> buffer, StorageSubItem &item, uint32_t depth) {
+        if (depth > MAX_DEPTH) {
+            DEBUG_FUNCTION_LINE_WARN("Sub items are nested deeper than %d levels", MAX_DEPTH);
+            return false;
+        }
+        size_t pos = 0;
+        while (pos < buffer.size()) {
+            if (buffer.size() - pos < ENTRY_HEADER_SIZE) {
+                DEBUG_FUNCTION_LINE_WARN("Truncated entry header");
+                return false;
+            }
+            auto type            = buffer[pos];
+            uint32_t keyLength   = Get16(&buffer[pos + 1]);
+            uint32_t valueLength = Get32(&buffer[pos + ENTRY_LENGTH_OFFSET]);
+            pos += ENTRY_HEADER_SIZE;
+            if (buffer.size() - pos < keyLength || buffer.size() - pos - keyLength < valueLength) {
+                DEBUG_FUNCTION_LINE_WARN("Truncated entry");
+                return false;
+            }
+            std::string_view key((const char *) &buffer[pos], keyLength);
+            auto value = buffer.subspan(pos + keyLength, valueLength);
+            pos += keyLength + valueLength;
+
+            StorageSubItem::StorageSubItemError error = StorageSubItem::STORAGE_SUB_ITEM_ERROR_NONE;
+            if (type == StorageBinaryFormat::ENTRY_TYPE_SUB_ITEM) {
+                auto res = item.createSubItem(key, error);
+                if (!res) {
+                    DEBUG_FUNCTION_LINE_WARN("Failed to create sub item: Error %d", error);
+                    return false;
+                }
+                if (!DeserializeEntries(value, *res, depth + 1)) {
+                    return false;
+                }
+                continue;
+            }
+            if (type > StorageBinaryFormat::ENTRY_TYPE_DOUBLE) {
+                DEBUG_FUNCTION_LINE_VERBOSE("Skip entry %.*s of unknown type %d", (int) key.size(), key.data(), type);
+                continue;
+            }
+            bool fixedSize = type == StorageBinaryFormat::ENTRY_TYPE_S64 || type == StorageBinaryFormat::ENTRY_TYPE_U64 || type == StorageBinaryFormat::ENTRY_TYPE_DOUBLE;
+            if ((type == StorageBinaryFormat::ENTRY_TYPE_BOOLEAN && valueLength != 1) || (fixedSize && valueLength != sizeof(uint64_t))) {
+                DEBUG_FUNCTION_LINE_WARN("Unexpected size %d of entry %.*s", valueLength, (int) key.size(), key.data());
+                return false;
+            }
+
+            auto res = item.createItem(key, error);
+            if (!res) {
+                DEBUG_FUNCTION_LINE_WARN("Failed to create Item for key %.*s. Error %d", (int) key.size(), key.data(), error);
+                return false;
+            }
+            switch (type) {
+                case StorageBinaryFormat::ENTRY_TYPE_BOOLEAN:
+                    res->setValue(value[0] != 0);
+                    break;
+                case StorageBinaryFormat::ENTRY_TYPE_STRING:
+                    res->setValue(std::string_view((const char *) value.data(), value.size()));
+                    break;
+                case StorageBinaryFormat::ENTRY_TYPE_BINARY:
+                    res->setValue(value);
+                    break;
+                case StorageBinaryFormat::ENTRY_TYPE_S64:
+                    res->setValue((int64_t) Get64(value.data()));
+                    break;
+                case StorageBinaryFormat::ENTRY_TYPE_U64:
+                    res->setValue(Get64(value.data()));
+                    break;
+                case StorageBinaryFormat::ENTRY_TYPE_DOUBLE:
+                    res->setValue(std::bit_cast<double>(Get64(value.data())));
+                    break;
+                default:
+                    break;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+bool StorageBinaryFormat::IsBinaryFormat(std::span<const uint8_t> buffer) {
+    return buffer.size() >= HEADER_SIZE && memcmp(buffer.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool StorageBinaryFormat::Serialize(const StorageSubItem &item, BufferedFileWriter &out) {
+    uint8_t header[HEADER_SIZE];
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    Put32(&header[sizeof(MAGIC)], VERSION);
+    return out.write(header, sizeof(header)) && SerializeEntries(item, out);
+}
+
+bool StorageBinaryFormat::Deserialize(std::span<const uint8_t> buffer, StorageSubItem &item) {
+    if (!IsBinaryFormat(buffer)) {
+        DEBUG_FUNCTION_LINE_WARN("Not a binary storage");
+        return false;
+    }
+    if (auto version = Get32(&buffer[sizeof(MAGIC)]); version != VERSION) {
+        DEBUG_FUNCTION_LINE_WARN("Unsupported binary storage version %d", version);
+        return false;
+    }
+    return DeserializeEntries(buffer.subspan(HEADER_SIZE), item, 0);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "StorageSubItem.h"
+#include "fs/BufferedFileWriter.h"
+#include <cstdint>
+#include <span>
+
+/**
+ * Compact on-disk format of a storage tree.
+ *
+ * All numbers are big endian. A file starts with the magic "WSTG" and a 32 bit version, followed by the
+ * entries of the root. Each entry is
+ *
+ *     uint8_t  type        (StorageBinaryFormat::EntryType)
+ *     uint16_t keyLength
+ *     uint32_t valueLength
+ *     char     key[keyLength]
+ *     uint8_t  value[valueLength]
+ *
+ * Booleans are stored as one byte, S64/U64/Double as 8 bytes. Strings and binary data are stored as raw bytes
+ * without a terminator. The value of a sub item consists of the entries of the sub item.
+ * Entries of an unknown type are skipped.
+ */
+namespace StorageBinaryFormat {
+    enum EntryType : uint8_t {
+        ENTRY_TYPE_SUB_ITEM = 0,
+        ENTRY_TYPE_BOOLEAN  = 1,
+        ENTRY_TYPE_STRING   = 2,
+        ENTRY_TYPE_BINARY   = 3,
+        ENTRY_TYPE_S64      = 4,
+        ENTRY_TYPE_U64      = 5,
+        ENTRY_TYPE_DOUBLE   = 6,
+    };
+
+    /**
+     * Returns true if the buffer starts with the magic of this format.
+     */
+    bool IsBinaryFormat(std::span<const uint8_t> buffer);
+
+    bool Serialize(const StorageSubItem &item, BufferedFileWriter &out);
+
+    /**
+     * Adds all entries of the buffer to item.
+     * @return false if the buffer is not a valid storage or sub items are nested too deep. The item might contain parts of the storage then.
+     */
+    bool Deserialize(std::span<const uint8_t> buffer, StorageSubItem &item);
+} // namespace StorageBinaryFormat
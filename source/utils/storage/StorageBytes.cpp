@@ -0,0 +1,45 @@
+#include "StorageBytes.h"
+#include <cstring>
+
+StorageBytes::StorageBytes(std::span<const uint8_t> data, std::pmr::memory_resource *resource) : mResource(resource) {
+    assign(data);
+}
+
+StorageBytes::StorageBytes(StorageBytes &&src) noexcept : mResource(src.mResource), mSize(src.mSize), mCapacity(src.mCapacity) {
+    if (src.isInline()) {
+        memcpy(mInline, src.mInline, mSize + 1);
+    } else {
+        mAllocated = src.mAllocated;
+    }
+    src.mSize      = 0;
+    src.mCapacity  = INLINE_SIZE;
+    src.mInline[0] = '\0';
+}
+
+StorageBytes::~StorageBytes() {
+    if (!isInline()) {
+        mResource->deallocate(mAllocated, mCapacity, 1);
+    }
+}
+
+void StorageBytes::assign(std::span<const uint8_t> data) {
+    uint32_t size = data.size();
+    if (size < mCapacity) {
+        // data might be a part of the current value.
+        uint8_t *dst = isInline() ? mInline : mAllocated;
+        if (size > 0) {
+            memmove(dst, data.data(), size);
+        }
+        dst[size] = '\0';
+    } else {
+        auto dst = (uint8_t *) mResource->allocate(size + 1, 1);
+        memcpy(dst, data.data(), size);
+        dst[size] = '\0';
+        if (!isInline()) {
+            mResource->deallocate(mAllocated, mCapacity, 1);
+        }
+        mAllocated = dst;
+        mCapacity  = size + 1;
+    }
+    mSize = size;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+
+/**
+ * Value of a string or binary item.
+ *
+ * Most values are short strings or small binaries, they are stored inline and need no allocation at all.
+ * Bigger values are allocated from the memory resource of the tree. The bytes are always followed by a null
+ * terminator, so string values can be passed to C functions.
+ */
+class StorageBytes {
+public:
+    // Including the null terminator.
+    static constexpr uint32_t INLINE_SIZE = 20;
+
+    StorageBytes(std::span<const uint8_t> data, std::pmr::memory_resource *resource);
+
+    StorageBytes(StorageBytes &&src) noexcept;
+
+    StorageBytes(const StorageBytes &) = delete;
+
+    StorageBytes &operator=(const StorageBytes &) = delete;
+
+    StorageBytes &operator=(StorageBytes &&) = delete;
+
+    ~StorageBytes();
+
+    /**
+     * Replaces the value, the memory of the old value is reused if the new value fits into it.
+     */
+    void assign(std::span<const uint8_t> data);
+
+    [[nodiscard]] std::span<const uint8_t> bytes() const {
+        return {data(), mSize};
+    }
+
+    [[nodiscard]] std::string_view str() const {
+        return {c_str(), mSize};
+    }
+
+    [[nodiscard]] const char *c_str() const {
+        return (const char *) data();
+    }
+
+    [[nodiscard]] uint32_t size() const {
+        return mSize;
+    }
+
+    [[nodiscard]] bool isInline() const {
+        return mCapacity == INLINE_SIZE;
+    }
+
+private:
+    [[nodiscard]] const uint8_t *data() const {
+        return isInline() ? mInline : mAllocated;
+    }
+
+    std::pmr::memory_resource *mResource;
+    uint32_t mSize     = 0;
+    uint32_t mCapacity = INLINE_SIZE;
+    union {
+        uint8_t mInline[INLINE_SIZE];
+        uint8_t *mAllocated;
+    };
+};
@@ -0,0 +1,74 @@
+#include "StorageHandleTable.h"
+#include "utils/logger.h"
+#include <vector>
+
+namespace StorageHandleTable {
+    namespace {
+        constexpr uint32_t INDEX_BITS      = 20;
+        constexpr uint32_t INDEX_MASK      = (1 << INDEX_BITS) - 1;
+        constexpr uint32_t GENERATION_MASK = (1 << (32 - INDEX_BITS)) - 1;
+
+        struct Slot {
+            StorageSubItem *item = nullptr;
+            uint32_t root        = 0;
+            // Never 0, so a valid handle is never 0 (nullptr) either.
+            uint32_t generation = 1;
+        };
+
+        std::vector<Slot> sSlots;
+        std::vector<uint32_t> sFreeSlots;
+
+        Slot *GetSlot(uint32_t handle) {
+            uint32_t index = handle & INDEX_MASK;
+            if (index >= sSlots.size()) {
+                return nullptr;
+            }
+            auto &slot = sSlots[index];
+            if (slot.item == nullptr || slot.generation != (handle >> INDEX_BITS)) {
+                return nullptr;
+            }
+            return &slot;
+        }
+    } // namespace
+
+    uint32_t Add(StorageSubItem *item, uint32_t root) {
+        uint32_t index;
+        if (!sFreeSlots.empty()) {
+            index = sFreeSlots.back();
+            sFreeSlots.pop_back();
+        } else {
+            if (sSlots.size() > INDEX_MASK) {
+                DEBUG_FUNCTION_LINE_ERR("Too many storage handles");
+                return 0;
+            }
+            index = sSlots.size();
+            sSlots.emplace_back();
+        }
+        auto &slot = sSlots[index];
+        slot.item  = item;
+        slot.root  = root;
+        return (slot.generation << INDEX_BITS) | index;
+    }
+
+    void Remove(uint32_t handle) {
+        auto slot = GetSlot(handle);
+        if (!slot) {
+            return;
+        }
+        slot->item       = nullptr;
+        slot->root       = 0;
+        slot->generation = (slot->generation + 1) & GENERATION_MASK;
+        if (slot->generation == 0) {
+            slot->generation = 1;
+        }
+        sFreeSlots.push_back(handle & INDEX_MASK);
+    }
+
+    StorageSubItem *Get(uint32_t handle, uint32_t root) {
+        auto slot = GetSlot(handle);
+        if (!slot || slot->root != root) {
+            return nullptr;
+        }
+        return slot->item;
+    }
+} // namespace StorageHandleTable
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+class StorageSubItem;
+
+/**
+ * Maps the handles that are passed to plugins (wups_storage_root_item/wups_storage_item) to storage roots and
+ * sub items in O(1). A handle is the index of a slot combined with the generation of that slot. The generation is
+ * increased whenever a slot is freed, so handles of deleted items are detected even if their slot is reused.
+ *
+ * Every slot also stores the handle of the root it belongs to (0 for roots), so a sub item can only be accessed
+ * through the storage it was created in.
+ *
+ * Not thread safe, the table is only accessed while the storage mutex is held.
+ */
+namespace StorageHandleTable {
+    /**
+     * @return the new handle or 0 if the table is full.
+     */
+    uint32_t Add(StorageSubItem *item, uint32_t root);
+
+    void Remove(uint32_t handle);
+
+    /**
+     * @return the item of the handle, or nullptr if the handle is not valid (anymore) or belongs to a different root.
+     */
+    StorageSubItem *Get(uint32_t handle, uint32_t root);
+} // namespace StorageHandleTable
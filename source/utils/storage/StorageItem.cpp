@@ -1,61 +1,67 @@
 #include "StorageItem.h"
+#include <algorithm>
+
+StorageItem::StorageItem(const StorageItem &src, std::pmr::memory_resource *resource) : mType(src.mType), mKey(src.mKey, resource), mBinaryConversionDone(src.mBinaryConversionDone) {
+    std::visit(
+            [this, resource](const auto &value) {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, StorageBytes>) {
+                    mData.emplace<StorageBytes>(value.bytes(), resource);
+                } else {
+                    mData.emplace<T>(value);
+                }
+            },
+            src.mData);
+}
 
-void StorageItem::setValue(const std::string &value) {
-    mData                 = value;
-    mType                 = StorageItemType::String;
-    mBinaryConversionDone = false;
+bool StorageItem::assignBytes(std::span<const uint8_t> value, StorageItemType type, bool binaryConversionDone) {
+    if (auto bytes = std::get_if<StorageBytes>(&mData)) {
+        if (mType == type && std::ranges::equal(bytes->bytes(), value)) {
+            return false;
+        }
+        bytes->assign(value);
+    } else {
+        mData.emplace<StorageBytes>(value, getResource());
+    }
+    mType                 = type;
+    mBinaryConversionDone = binaryConversionDone;
+    return true;
 }
 
-void StorageItem::setValue(bool value) {
-    mData                 = value;
-    mType                 = StorageItemType::Boolean;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(std::string_view value) {
+    return assignBytes({(const uint8_t *) value.data(), value.size()}, StorageItemType::String, false);
 }
 
-void StorageItem::setValue(int32_t value) {
-    mData                 = (int64_t) value;
-    mType                 = StorageItemType::S64;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(bool value) {
+    return assign(value, StorageItemType::Boolean, true);
 }
 
-void StorageItem::setValue(int64_t value) {
-    mData                 = value;
-    mType                 = StorageItemType::S64;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(int32_t value) {
+    return assign((int64_t) value, StorageItemType::S64, true);
 }
 
-void StorageItem::setValue(uint64_t value) {
-    mData                 = value;
-    mType                 = StorageItemType::U64;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(int64_t value) {
+    return assign(value, StorageItemType::S64, true);
 }
 
-void StorageItem::setValue(uint32_t value) {
-    mData                 = (uint64_t) value;
-    mType                 = StorageItemType::U64;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(uint64_t value) {
+    return assign(value, StorageItemType::U64, true);
 }
 
-void StorageItem::setValue(float value) {
-    mData                 = (double) value;
-    mType                 = StorageItemType::Double;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(uint32_t value) {
+    return assign((uint64_t) value, StorageItemType::U64, true);
 }
 
-void StorageItem::setValue(double value) {
-    mData                 = value;
-    mType                 = StorageItemType::Double;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(float value) {
+    return assign((double) value, StorageItemType::Double, true);
 }
 
-void StorageItem::setValue(const std::vector<uint8_t> &data) {
-    mData                 = data;
-    mType                 = StorageItemType::Binary;
-    mBinaryConversionDone = true;
+bool StorageItem::setValue(double value) {
+    return assign(value, StorageItemType::Double, true);
 }
 
-void StorageItem::setValue(const uint8_t *data, size_t size) {
-    setValue(std::vector<uint8_t>(data, data + size));
+bool StorageItem::setValue(std::span<const uint8_t> data) {
+    return assignBytes(data, StorageItemType::Binary, true);
 }
 
 bool StorageItem::getValue(bool &result) const {
@@ -85,7 +91,8 @@ bool StorageItem::getValue(int32_t &result) const {
 
 bool StorageItem::getValue(std::vector<uint8_t> &result) const {
     if (mType == StorageItemType::Binary) {
-        result = std::get<std::vector<uint8_t>>(mData);
+        auto binary = std::get<StorageBytes>(mData).bytes();
+        result.assign(binary.begin(), binary.end());
         return true;
     }
     return false;
@@ -93,7 +100,23 @@ bool StorageItem::getValue(std::vector<uint8_t> &result) const {
 
 bool StorageItem::getValue(std::string &result) const {
     if (mType == StorageItemType::String) {
-        result = std::get<std::string>(mData);
+        result = std::get<StorageBytes>(mData).str();
+        return true;
+    }
+    return false;
+}
+
+bool StorageItem::getValue(std::string_view &result) const {
+    if (mType == StorageItemType::String) {
+        result = std::get<StorageBytes>(mData).str();
+        return true;
+    }
+    return false;
+}
+
+bool StorageItem::getValue(std::span<const uint8_t> &result) const {
+    if (mType == StorageItemType::Binary) {
+        result = std::get<StorageBytes>(mData).bytes();
         return true;
     }
     return false;
@@ -150,7 +173,7 @@ bool StorageItem::getValue(int64_t &result) const {
 
 bool StorageItem::getItemSizeString(uint32_t &outSize) const {
     if (mType == StorageItemType::String) {
-        outSize = (std::get<std::string>(mData).length() + 1);
+        outSize = (std::get<StorageBytes>(mData).size() + 1);
         return true;
     }
     return false;
@@ -158,7 +181,7 @@ bool StorageItem::getItemSizeString(uint32_t &outSize) const {
 
 bool StorageItem::getItemSizeBinary(uint32_t &outSize) const {
     if (mType == StorageItemType::Binary) {
-        outSize = std::get<std::vector<uint8_t>>(mData).size();
+        outSize = std::get<StorageBytes>(mData).size();
         return true;
     }
     return false;
@@ -169,13 +192,13 @@ bool StorageItem::attemptBinaryConversion() {
         return true;
     }
     if (mType == StorageItemType::String) {
-        auto &tmp     = std::get<std::string>(mData);
+        auto &tmp     = std::get<StorageBytes>(mData);
         auto dec_size = b64_decoded_size(tmp.c_str());
         if (dec_size > 0) {
             auto *dec = (uint8_t *) malloc(dec_size);
             if (dec) {
                 if (b64_decode(tmp.c_str(), dec, dec_size)) {
-                    setValue(dec, dec_size);
+                    setValue(std::span<const uint8_t>(dec, dec_size));
                 }
                 free(dec);
             } else {
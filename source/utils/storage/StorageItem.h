@@ -1,10 +1,14 @@
 #pragma once
 
+#include "StorageBytes.h"
 #include "utils/base64.h"
 #include "utils/logger.h"
 #include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -17,35 +21,50 @@ enum class StorageItemType { None,
                              U64,
                              Double };
 
+/**
+ * Key and value of an item are allocated from the memory resource of the tree (see StorageArena).
+ */
 class StorageItem {
 public:
-    explicit StorageItem(std::string_view key) : mData(std::monostate{}), mType(StorageItemType::None), mKey(key) {
+    StorageItem(std::string_view key, std::pmr::memory_resource *resource) : mData(std::monostate{}), mType(StorageItemType::None), mKey(key, resource) {
     }
 
-    [[nodiscard]] uint32_t getHandle() const {
-        return (uint32_t) this;
-    }
+    /**
+     * Copies the item into a different memory resource.
+     */
+    StorageItem(const StorageItem &src, std::pmr::memory_resource *resource);
+
+    StorageItem(StorageItem &&src) noexcept = default;
+
+    // A plain copy would allocate from the default memory resource.
+    StorageItem(const StorageItem &) = delete;
 
-    // Setters for different types
-    void setValue(bool value);
+    StorageItem &operator=(const StorageItem &) = delete;
+
+    StorageItem &operator=(StorageItem &&) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource *getResource() const {
+        return mKey.get_allocator().resource();
+    }
 
-    void setValue(const std::string &value);
+    // Setters for different types, return false if the item already had this value.
+    bool setValue(bool value);
 
-    void setValue(int32_t value);
+    bool setValue(std::string_view value);
 
-    void setValue(int64_t value);
+    bool setValue(int32_t value);
 
-    void setValue(uint64_t value);
+    bool setValue(int64_t value);
 
-    void setValue(uint32_t value);
+    bool setValue(uint64_t value);
 
-    void setValue(float value);
+    bool setValue(uint32_t value);
 
-    void setValue(double value);
+    bool setValue(float value);
 
-    void setValue(const std::vector<uint8_t> &data);
+    bool setValue(double value);
 
-    void setValue(const uint8_t *data, size_t size);
+    bool setValue(std::span<const uint8_t> data);
 
     bool getValue(bool &result) const;
 
@@ -65,11 +84,16 @@ public:
 
     bool getValue(std::vector<uint8_t> &result) const;
 
+    // Views of the stored value, only valid until the item is changed.
+    bool getValue(std::string_view &result) const;
+
+    bool getValue(std::span<const uint8_t> &result) const;
+
     [[nodiscard]] StorageItemType getType() const {
         return mType;
     }
 
-    [[nodiscard]] const std::string &getKey() const {
+    [[nodiscard]] std::string_view getKey() const {
         return mKey;
     }
 
@@ -80,9 +104,23 @@ public:
     bool attemptBinaryConversion();
 
 private:
-    std::variant<std::monostate, std::string, bool, int64_t, uint64_t, double, std::vector<uint8_t>> mData = std::monostate{};
-    StorageItemType mType                                                                                  = StorageItemType::None;
-    std::string mKey                                                                                       = {};
+    template<typename T>
+    bool assign(const T &value, StorageItemType type, bool binaryConversionDone) {
+        if (mType == type && std::holds_alternative<T>(mData) && std::get<T>(mData) == value) {
+            return false;
+        }
+        mData                 = value;
+        mType                 = type;
+        mBinaryConversionDone = binaryConversionDone;
+        return true;
+    }
+
+    bool assignBytes(std::span<const uint8_t> value, StorageItemType type, bool binaryConversionDone);
+
+    // Strings and binary data are both stored as StorageBytes, mType tells them apart.
+    std::variant<std::monostate, StorageBytes, bool, int64_t, uint64_t, double> mData = std::monostate{};
+    StorageItemType mType                                                              = StorageItemType::None;
+    std::pmr::string mKey;
 
     bool mBinaryConversionDone = true;
 };
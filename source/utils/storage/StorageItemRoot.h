@@ -1,5 +1,6 @@
 #pragma once
 
+#include "StorageArena.h"
 #include "StorageItem.h"
 #include "StorageSubItem.h"
 #include "utils/logger.h"
@@ -10,20 +11,80 @@
 #include <vector>
 #include <wups/storage.h>
 
-class StorageItemRoot : public StorageSubItem {
+/**
+ * Holds the arena of a StorageItemRoot. It's the first base class of the root, so the arena is created before
+ * and destroyed after the tree.
+ */
+class StorageArenaOwner {
+protected:
+    explicit StorageArenaOwner(std::unique_ptr<StorageArena> arena) : mArena(std::move(arena)) {
+    }
+
+    std::unique_ptr<StorageArena> mArena;
+};
+
+/**
+ * The whole tree of a root is allocated from its own StorageArena.
+ * The root itself has no key, so besides the child index nothing of the root lives in the arena.
+ */
+class StorageItemRoot : private StorageArenaOwner, public StorageSubItem {
 public:
-    explicit StorageItemRoot(std::string_view plugin_name) : StorageSubItem(plugin_name), mPluginName(plugin_name) {
+    explicit StorageItemRoot(std::string_view plugin_name) : StorageArenaOwner(std::make_unique<StorageArena>()),
+                                                             StorageSubItem({}, mArena.get()),
+                                                             mPluginName(plugin_name) {
     }
 
+    /**
+     * Copies the tree into a new arena.
+     */
+    StorageItemRoot(const StorageItemRoot &src) : StorageArenaOwner(std::make_unique<StorageArena>()),
+                                                  StorageSubItem(src, mArena.get()),
+                                                  mPluginName(src.mPluginName),
+                                                  mDirty(src.mDirty) {
+    }
+
+    StorageItemRoot(StorageItemRoot &&src) noexcept = default;
+
+    StorageItemRoot &operator=(const StorageItemRoot &) = delete;
+
+    StorageItemRoot &operator=(StorageItemRoot &&) = delete;
+
     [[nodiscard]] const std::string &getPluginId() const {
         return mPluginName;
     }
 
+    /**
+     * Removes all items. The old tree is returned to the heap in one step together with its arena.
+     */
     void wipe() {
-        mSubCategories.clear();
-        mItems.clear();
+        auto arena = std::make_unique<StorageArena>();
+        resetChildren(arena.get());
+        mArena = std::move(arena);
+        mDirty = true;
+    }
+
+    [[nodiscard]] const StorageArena &getArena() const {
+        return *mArena;
+    }
+
+    /**
+     * Has to be called after every change of the tree (e.g. items stored, created or deleted),
+     * so closing an unchanged storage doesn't need to touch the SD card.
+     */
+    void markDirty() {
+        mDirty = true;
+    }
+
+    void markClean() {
+        mDirty = false;
+    }
+
+    [[nodiscard]] bool isDirty() const {
+        return mDirty;
     }
 
 private:
     std::string mPluginName;
+    // Whether the tree differs from the file on the SD card.
+    bool mDirty = false;
 };
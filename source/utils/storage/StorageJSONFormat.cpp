@@ -0,0 +1,387 @@
+#include "StorageJSONFormat.h"
+#include "utils/base64.h"
+#include "utils/json.hpp"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    // Binary items are encoded in chunks of this size, a multiple of 3 so the chunks can be concatenated.
+    constexpr size_t BASE64_CHUNK_SIZE = 0x300;
+
+    /**
+     * @return the length of the UTF-8 encoded code point at the start of str, or 0 if it's not valid UTF-8.
+     */
+    size_t GetUTF8SequenceLength(std::string_view str) {
+        auto lead = (uint8_t) str[0];
+        // Range of the second byte, excludes overlong encodings, surrogates and code points above U+10FFFF.
+        uint8_t min = 0x80;
+        uint8_t max = 0xBF;
+        size_t length;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            if (lead == 0xE0) {
+                min = 0xA0;
+            } else if (lead == 0xED) {
+                max = 0x9F;
+            }
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            if (lead == 0xF0) {
+                min = 0x90;
+            } else if (lead == 0xF4) {
+                max = 0x8F;
+            }
+        } else {
+            return 0;
+        }
+        if (str.size() < length) {
+            return 0;
+        }
+        for (size_t i = 1; i < length; i++) {
+            auto cur = (uint8_t) str[i];
+            if (cur < min || cur > max) {
+                return 0;
+            }
+            min = 0x80;
+            max = 0xBF;
+        }
+        return length;
+    }
+
+    /**
+     * Writes the same layout as nlohmann::json::dump(4, ' '), but the members of an object are written in the order of the child index.
+     */
+    class StorageJSONWriter {
+    public:
+        explicit StorageJSONWriter(BufferedFileWriter &out) : mOut(out) {
+        }
+
+        bool writeDocument(const StorageSubItem &item) {
+            mOut.write("{\n    \"storageitems\": ");
+            writeObject(item, 1);
+            mOut.write("\n}");
+            return !mOut.hasFailed() && !mFailed;
+        }
+
+    private:
+        void indent(uint32_t level) {
+            for (uint32_t i = 0; i < level; i++) {
+                mOut.write("    ");
+            }
+        }
+
+        /**
+         * Invalid UTF-8 sequences are dropped like nlohmann::json::dump(..., error_handler_t::ignore) does, the file couldn't be parsed otherwise.
+         */
+        void writeString(std::string_view str) {
+            mOut.put('"');
+            for (size_t i = 0; i < str.size(); i++) {
+                char c = str[i];
+                if ((uint8_t) c >= 0x80) {
+                    if (auto length = GetUTF8SequenceLength(str.substr(i)); length > 0) {
+                        mOut.write(str.data() + i, length);
+                        i += length - 1;
+                    }
+                    continue;
+                }
+                switch (c) {
+                    case '"':
+                        mOut.write("\\\"");
+                        break;
+                    case '\\':
+                        mOut.write("\\\\");
+                        break;
+                    case '\b':
+                        mOut.write("\\b");
+                        break;
+                    case '\f':
+                        mOut.write("\\f");
+                        break;
+                    case '\n':
+                        mOut.write("\\n");
+                        break;
+                    case '\r':
+                        mOut.write("\\r");
+                        break;
+                    case '\t':
+                        mOut.write("\\t");
+                        break;
+                    default:
+                        if ((uint8_t) c < 0x20) {
+                            char escaped[8];
+                            snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t) c);
+                            mOut.write(escaped);
+                        } else {
+                            mOut.put(c);
+                        }
+                        break;
+                }
+            }
+            mOut.put('"');
+        }
+
+        void writeBase64(std::span<const uint8_t> data) {
+            mOut.put('"');
+            for (size_t offset = 0; offset < data.size(); offset += BASE64_CHUNK_SIZE) {
+                auto chunk = data.subspan(offset, std::min(BASE64_CHUNK_SIZE, data.size() - offset));
+                auto *enc  = b64_encode(chunk.data(), chunk.size());
+                if (!enc) {
+                    DEBUG_FUNCTION_LINE_WARN("Failed to store binary item: Malloc failed");
+                    mFailed = true;
+                    return;
+                }
+                mOut.write(enc);
+                free(enc);
+            }
+            mOut.put('"');
+        }
+
+        void writeDouble(double value) {
+            if (!std::isfinite(value)) {
+                mOut.write("null");
+                return;
+            }
+            char buf[64];
+            auto *end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), value);
+            mOut.write(buf, end - buf);
+        }
+
+        void writeValue(const StorageItem &item) {
+            char buf[32];
+            switch (item.getType()) {
+                case StorageItemType::String: {
+                    std::string_view res;
+                    item.getValue(res);
+                    writeString(res);
+                    break;
+                }
+                case StorageItemType::Boolean: {
+                    bool res = false;
+                    item.getValue(res);
+                    mOut.write(res ? "true" : "false");
+                    break;
+                }
+                case StorageItemType::S64: {
+                    int64_t res = 0;
+                    item.getValue(res);
+                    snprintf(buf, sizeof(buf), "%" PRId64, res);
+                    mOut.write(buf);
+                    break;
+                }
+                case StorageItemType::U64: {
+                    uint64_t res = 0;
+                    item.getValue(res);
+                    snprintf(buf, sizeof(buf), "%" PRIu64, res);
+                    mOut.write(buf);
+                    break;
+                }
+                case StorageItemType::Double: {
+                    double res = 0;
+                    item.getValue(res);
+                    writeDouble(res);
+                    break;
+                }
+                case StorageItemType::Binary: {
+                    std::span<const uint8_t> res;
+                    item.getValue(res);
+                    writeBase64(res);
+                    break;
+                }
+                case StorageItemType::None:
+                    break;
+            }
+        }
+
+        void beginMember(bool &first, uint32_t level, std::string_view key) {
+            mOut.write(first ? "\n" : ",\n");
+            first = false;
+            indent(level);
+            writeString(key);
+            mOut.write(": ");
+        }
+
+        void writeObject(const StorageSubItem &item, uint32_t level) {
+            bool first = true;
+            mOut.put('{');
+            for (const auto &[key, child] : item.getChildren()) {
+                if (auto subItem = std::get_if<StorageNodePtr<StorageSubItem>>(&child)) {
+                    beginMember(first, level + 1, key);
+                    writeObject(**subItem, level + 1);
+                    continue;
+                }
+                const auto &value = *std::get<StorageNodePtr<StorageItem>>(child);
+                if (value.getType() == StorageItemType::None) {
+                    DEBUG_FUNCTION_LINE_WARN("Skip: StorageItemType::None");
+                    continue;
+                }
+                beginMember(first, level + 1, key);
+                writeValue(value);
+            }
+            if (!first) {
+                mOut.put('\n');
+                indent(level);
+            }
+            mOut.put('}');
+        }
+
+        BufferedFileWriter &mOut;
+        bool mFailed = false;
+    };
+
+    /**
+     * SAX handler that adds the "storageitems" of a storage JSON file to a StorageSubItem while it's parsed,
+     * without building a DOM first. Everything outside of "storageitems" is ignored.
+     */
+    class StorageJSONReader {
+    public:
+        explicit StorageJSONReader(StorageSubItem &root) : mRoot(root) {
+        }
+
+        bool null() {
+            if (isInStorageItems()) {
+                DEBUG_FUNCTION_LINE_ERR("Unknown type null for value %s", mKey.c_str());
+            }
+            return true;
+        }
+
+        bool boolean(bool val) {
+            return setValue(val);
+        }
+
+        bool number_integer(nlohmann::json::number_integer_t val) {
+            return setValue((int64_t) val);
+        }
+
+        bool number_unsigned(nlohmann::json::number_unsigned_t val) {
+            return setValue((uint64_t) val);
+        }
+
+        bool number_float(nlohmann::json::number_float_t val, const nlohmann::json::string_t &) {
+            return setValue((double) val);
+        }
+
+        bool string(nlohmann::json::string_t &val) {
+            return setValue(val);
+        }
+
+        bool binary(nlohmann::json::binary_t &) {
+            return true;
+        }
+
+        bool start_object(std::size_t) {
+            if (mSkipDepth > 0) {
+                mSkipDepth++;
+                return true;
+            }
+            if (!mInDocument) {
+                mInDocument = true;
+                return true;
+            }
+            if (mStack.empty()) {
+                if (mKey == "storageitems" && !mHasStorageItems) {
+                    mHasStorageItems = true;
+                    mStack.push_back(&mRoot);
+                } else {
+                    mSkipDepth = 1;
+                }
+                return true;
+            }
+            // Like with a parsed DOM, the last value of a duplicate key wins.
+            mStack.back()->deleteItem(mKey);
+            StorageSubItem::StorageSubItemError error = StorageSubItem::STORAGE_SUB_ITEM_ERROR_NONE;
+            auto res                                  = mStack.back()->createSubItem(mKey, error);
+            if (!res) {
+                DEBUG_FUNCTION_LINE_WARN("Failed to create sub item: Error %d", error);
+                return false;
+            }
+            mStack.push_back(res);
+            return true;
+        }
+
+        bool end_object() {
+            if (mSkipDepth > 0) {
+                mSkipDepth--;
+            } else if (!mStack.empty()) {
+                mStack.pop_back();
+            }
+            return true;
+        }
+
+        bool start_array(std::size_t) {
+            if (mSkipDepth == 0 && isInStorageItems()) {
+                DEBUG_FUNCTION_LINE_ERR("Unknown type array for value %s", mKey.c_str());
+            }
+            mSkipDepth++;
+            return true;
+        }
+
+        bool end_array() {
+            mSkipDepth--;
+            return true;
+        }
+
+        bool key(nlohmann::json::string_t &val) {
+            if (mSkipDepth == 0) {
+                mKey = val;
+            }
+            return true;
+        }
+
+        template<typename Exception>
+        bool parse_error(std::size_t position, const std::string &, const Exception &) {
+            DEBUG_FUNCTION_LINE_WARN("Failed to parse storage at position %d", position);
+            return false;
+        }
+
+        [[nodiscard]] bool hasStorageItems() const {
+            return mHasStorageItems;
+        }
+
+    private:
+        [[nodiscard]] bool isInStorageItems() const {
+            return mSkipDepth == 0 && !mStack.empty();
+        }
+
+        template<typename T>
+        bool setValue(const T &value) {
+            if (!isInStorageItems()) {
+                return true;
+            }
+            // Like with a parsed DOM, the last value of a duplicate key wins.
+            mStack.back()->deleteItem(mKey);
+            StorageSubItem::StorageSubItemError error = StorageSubItem::STORAGE_SUB_ITEM_ERROR_NONE;
+            auto res                                  = mStack.back()->createItem(mKey, error);
+            if (!res) {
+                DEBUG_FUNCTION_LINE_WARN("Failed to create Item for key %s. Error %d", mKey.c_str(), error);
+                return false;
+            }
+            res->setValue(value);
+            return true;
+        }
+
+        StorageSubItem &mRoot;
+        // Sub items of the objects that are currently open, starting with the root for "storageitems".
+        std::vector<StorageSubItem *> mStack;
+        std::string mKey;
+        // Depth of the array or object that is currently skipped, 0 if nothing is skipped.
+        uint32_t mSkipDepth   = 0;
+        bool mInDocument      = false;
+        bool mHasStorageItems = false;
+    };
+} // namespace
+
+bool StorageJSONFormat::Serialize(const StorageSubItem &item, BufferedFileWriter &out) {
+    return StorageJSONWriter(out).writeDocument(item);
+}
+
+bool StorageJSONFormat::Deserialize(std::span<const uint8_t> buffer, StorageSubItem &item) {
+    StorageJSONReader reader(item);
+    return nlohmann::json::sax_parse(buffer.begin(), buffer.end(), &reader) && reader.hasStorageItems();
+}
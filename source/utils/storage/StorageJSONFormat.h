@@ -0,0 +1,26 @@
+#pragma once
+
+#include "StorageSubItem.h"
+#include "fs/BufferedFileWriter.h"
+#include <cstdint>
+#include <span>
+
+/**
+ * The JSON format storages used to be saved in:
+ *
+ *     { "storageitems": { "key": value, "subItem": { ... } } }
+ *
+ * Binary items are stored as base64 encoded strings and only get converted back once they are read as binary.
+ */
+namespace StorageJSONFormat {
+    /**
+     * Streams the storage to out, nothing but the buffer of out is needed for this.
+     */
+    bool Serialize(const StorageSubItem &item, BufferedFileWriter &out);
+
+    /**
+     * Adds all "storageitems" of the buffer to item.
+     * @return false if the buffer is not a valid storage. The item might contain parts of the storage then.
+     */
+    bool Deserialize(std::span<const uint8_t> buffer, StorageSubItem &item);
+} // namespace StorageJSONFormat
@@ -1,84 +1,101 @@
 #include "StorageSubItem.h"
+#include "StorageHandleTable.h"
 
-StorageSubItem *StorageSubItem::getSubItem(wups_storage_item item) {
-    // Try to find the sub-item based on item handle.
-    for (auto &cur : mSubCategories) {
-        if (cur.getHandle() == (uint32_t) item) {
-            return &cur;
+StorageSubItem::StorageSubItem(const StorageSubItem &src, std::pmr::memory_resource *resource) : StorageItem(src, resource), mChildren(resource) {
+    mChildren.reserve(src.mChildren.size());
+    for (const auto &[key, child] : src.mChildren) {
+        if (auto subItem = std::get_if<StorageNodePtr<StorageSubItem>>(&child)) {
+            auto copy = MakeStorageNode<StorageSubItem>(resource, **subItem, resource);
+            mChildren.emplace(copy->getKey(), std::move(copy));
+        } else {
+            auto copy = MakeStorageNode<StorageItem>(resource, *std::get<StorageNodePtr<StorageItem>>(child), resource);
+            mChildren.emplace(copy->getKey(), std::move(copy));
         }
     }
+}
 
-    // If not found in current category, recursively search in sub-categories.
-    for (auto &cur : mSubCategories) {
-        auto res = cur.getSubItem(item);
-        if (res) {
-            return res;
-        }
+StorageSubItem::StorageSubItem(StorageSubItem &&src) noexcept : StorageItem(std::move(src)), mChildren(std::move(src.mChildren)) {
+}
+
+void StorageSubItem::resetChildren(std::pmr::memory_resource *resource) {
+    // The memory resource of a pmr container can't be changed by assigning a new one.
+    std::destroy_at(&mChildren);
+    std::construct_at(&mChildren, resource);
+}
+
+StorageSubItem::~StorageSubItem() {
+    if (mHandle != 0) {
+        StorageHandleTable::Remove(mHandle);
     }
+}
 
-    return nullptr;
+uint32_t StorageSubItem::getHandle(uint32_t root) {
+    if (mHandle == 0) {
+        mHandle = StorageHandleTable::Add(this, root);
+    }
+    return mHandle;
 }
 
-const StorageSubItem *StorageSubItem::getSubItem(const char *key) const {
-    // Try to find the sub-item based on key.
-    for (const auto &cur : mSubCategories) {
-        if (cur.getKey() == key) {
-            return &cur;
+void StorageSubItem::releaseHandles() {
+    if (mHandle != 0) {
+        StorageHandleTable::Remove(mHandle);
+        mHandle = 0;
+    }
+    for (auto &[key, child] : mChildren) {
+        if (auto subItem = std::get_if<StorageNodePtr<StorageSubItem>>(&child)) {
+            (*subItem)->releaseHandles();
         }
     }
+}
 
-    return nullptr;
+StorageSubItem *StorageSubItem::getSubItem(std::string_view key) {
+    return const_cast<StorageSubItem *>(std::as_const(*this).getSubItem(key));
 }
 
-bool StorageSubItem::deleteItem(const char *key) {
-    if (remove_first_if(mSubCategories, [key](auto &cur) { return cur.getKey() == key; })) {
-        return true;
+const StorageSubItem *StorageSubItem::getSubItem(std::string_view key) const {
+    auto itr = mChildren.find(key);
+    if (itr == mChildren.end()) {
+        return nullptr;
     }
+    auto subItem = std::get_if<StorageNodePtr<StorageSubItem>>(&itr->second);
+    return subItem ? subItem->get() : nullptr;
+}
 
-    auto itemItr = mItems.find(key);
-    if (itemItr != mItems.end()) {
-        mItems.erase(itemItr);
-        return true; // Item found and deleted.
-    }
-    return false;
+bool StorageSubItem::deleteItem(std::string_view key) {
+    return mChildren.erase(key) > 0;
 }
 
-StorageItem *StorageSubItem::createItem(const char *key, StorageSubItem::StorageSubItemError &error) {
-    for (const auto &cur : mSubCategories) {
-        if (cur.getKey() == key) {
-            error = STORAGE_SUB_ITEM_KEY_ALREADY_IN_USE;
-            return nullptr;
-        }
+StorageItem *StorageSubItem::createItem(std::string_view key, StorageSubItem::StorageSubItemError &error) {
+    if (mChildren.contains(key)) {
+        error = STORAGE_SUB_ITEM_KEY_ALREADY_IN_USE;
+        return nullptr;
     }
 
-    auto result = mItems.insert({key, StorageItem(key)});
-    if (result.second) {
-        return &result.first->second;
-    }
-    return nullptr;
+    auto resource = mChildren.get_allocator().resource();
+    auto item     = MakeStorageNode<StorageItem>(resource, key, resource);
+    auto res      = item.get();
+    mChildren.emplace(res->getKey(), std::move(item));
+    return res;
 }
 
-StorageSubItem *StorageSubItem::createSubItem(const char *key, StorageSubItem::StorageSubItemError &error) {
-    auto resItr = mItems.find(key);
-    if (resItr != mItems.end()) {
+StorageSubItem *StorageSubItem::createSubItem(std::string_view key, StorageSubItem::StorageSubItemError &error) {
+    if (mChildren.contains(key)) {
         error = STORAGE_SUB_ITEM_KEY_ALREADY_IN_USE;
         return nullptr;
     }
-    for (const auto &cur : mSubCategories) {
-        if (cur.getKey() == key) {
-            error = STORAGE_SUB_ITEM_KEY_ALREADY_IN_USE;
-            return nullptr;
-        }
-    }
 
-    mSubCategories.emplace_front(key);
-    return &mSubCategories.front();
+    auto resource = mChildren.get_allocator().resource();
+    auto subItem  = MakeStorageNode<StorageSubItem>(resource, key, resource);
+    auto res      = subItem.get();
+    mChildren.emplace(res->getKey(), std::move(subItem));
+    return res;
 }
 
-StorageItem *StorageSubItem::getItem(const char *name) {
-    auto resItr = mItems.find(name);
-    if (resItr != mItems.end()) {
-        return &resItr->second;
+StorageItem *StorageSubItem::getItem(std::string_view key) {
+    auto itr = mChildren.find(key);
+    if (itr == mChildren.end()) {
+        return nullptr;
     }
-    return nullptr;
+    auto item = std::get_if<StorageNodePtr<StorageItem>>(&itr->second);
+    return item ? item->get() : nullptr;
 }
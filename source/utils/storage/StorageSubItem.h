@@ -2,45 +2,120 @@
 
 #include "StorageItem.h"
 #include "utils/utils.h"
-#include <map>
 #include <memory>
+#include <memory_resource>
 #include <optional>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <variant>
 #include <vector>
 #include <wups/storage.h>
 
+/**
+ * Allows looking up keys of the child index with any string type, without creating a temporary std::string.
+ */
+struct StorageKeyHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view key) const noexcept {
+        return std::hash<std::string_view>{}(key);
+    }
+};
+
+/**
+ * Destroys a node of a storage tree and returns its memory to the memory resource of the tree.
+ */
+struct StorageNodeDeleter {
+    template<typename T>
+    void operator()(T *node) const {
+        auto resource = node->getResource();
+        std::destroy_at(node);
+        resource->deallocate(node, sizeof(T), alignof(T));
+    }
+};
+
+template<typename T>
+using StorageNodePtr = std::unique_ptr<T, StorageNodeDeleter>;
+
+template<typename T, typename... Args>
+StorageNodePtr<T> MakeStorageNode(std::pmr::memory_resource *resource, Args &&...args) {
+    auto node = (T *) resource->allocate(sizeof(T), alignof(T));
+    return StorageNodePtr<T>(std::construct_at(node, std::forward<Args>(args)...));
+}
+
 class StorageSubItem : public StorageItem {
 public:
+    using Child = std::variant<StorageNodePtr<StorageSubItem>, StorageNodePtr<StorageItem>>;
+    // Sub items and items share one key space, so both are stored in a single index.
+    // The keys are views of the key of the child, so every key is only stored once.
+    using ChildIndex = std::pmr::unordered_map<std::string_view, Child, StorageKeyHash, std::equal_to<>>;
+
     enum StorageSubItemError {
         STORAGE_SUB_ITEM_ERROR_NONE          = 0,
         STORAGE_SUB_ITEM_ERROR_MALLOC_FAILED = 1,
         STORAGE_SUB_ITEM_KEY_ALREADY_IN_USE  = 2,
     };
 
-    explicit StorageSubItem(std::string_view key) : StorageItem(key) {
+    /**
+     * @param resource memory resource for the key and all children, see StorageArena.
+     */
+    StorageSubItem(std::string_view key, std::pmr::memory_resource *resource) : StorageItem(key, resource), mChildren(resource) {
     }
 
-    StorageSubItem *getSubItem(wups_storage_item item);
+    /**
+     * Copies the item and all its children into a different memory resource.
+     * Copies and moves never take over the handle, it always stays with the object it was registered for.
+     */
+    StorageSubItem(const StorageSubItem &src, std::pmr::memory_resource *resource);
 
-    const StorageSubItem *getSubItem(const char *key) const;
+    StorageSubItem(StorageSubItem &&src) noexcept;
 
-    bool deleteItem(const char *key);
+    StorageSubItem(const StorageSubItem &) = delete;
 
-    StorageItem *createItem(const char *key, StorageSubItem::StorageSubItemError &error);
+    StorageSubItem &operator=(const StorageSubItem &) = delete;
 
-    StorageSubItem *createSubItem(const char *key, StorageSubItem::StorageSubItemError &error);
+    StorageSubItem &operator=(StorageSubItem &&) = delete;
 
-    StorageItem *getItem(const char *name);
+    ~StorageSubItem();
 
-    [[nodiscard]] const std::forward_list<StorageSubItem> &getSubItems() const {
-        return mSubCategories;
-    }
+    /**
+     * Returns the handle of this item for plugins, it's added to the StorageHandleTable on first use.
+     * @param root handle of the root this item belongs to, 0 if this is a root.
+     * @return 0 if no handle could be created.
+     */
+    uint32_t getHandle(uint32_t root);
+
+    /**
+     * Invalidates the handles of this item and all its sub items.
+     * Has to be called before the tree is passed to a different thread, the handle table is not thread safe.
+     */
+    void releaseHandles();
+
+    StorageSubItem *getSubItem(std::string_view key);
+
+    const StorageSubItem *getSubItem(std::string_view key) const;
+
+    bool deleteItem(std::string_view key);
 
-    [[nodiscard]] const std::map<std::string, StorageItem> &getItems() const {
-        return mItems;
+    StorageItem *createItem(std::string_view key, StorageSubItem::StorageSubItemError &error);
+
+    StorageSubItem *createSubItem(std::string_view key, StorageSubItem::StorageSubItemError &error);
+
+    StorageItem *getItem(std::string_view key);
+
+    [[nodiscard]] const ChildIndex &getChildren() const {
+        return mChildren;
     }
 
 protected:
-    std::forward_list<StorageSubItem> mSubCategories;
-    std::map<std::string, StorageItem> mItems;
+    /**
+     * Destroys all children and allocates new children from resource.
+     */
+    void resetChildren(std::pmr::memory_resource *resource);
+
+    ChildIndex mChildren;
+
+private:
+    uint32_t mHandle = 0;
 };
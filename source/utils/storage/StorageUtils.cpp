@@ -1,18 +1,25 @@
 #include "StorageUtils.h"
 #include "NotificationsUtils.h"
+#include "StorageBinaryFormat.h"
+#include "StorageHandleTable.h"
 #include "StorageItemRoot.h"
+#include "StorageJSONFormat.h"
+#include "fs/BufferedFileWriter.h"
 #include "fs/CFile.hpp"
 #include "fs/FSUtils.h"
 #include "utils/StringTools.h"
-#include "utils/base64.h"
-#include "utils/json.hpp"
+#include "utils/TaskRuntime.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
+#include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 namespace StorageUtils {
     std::forward_list<StorageItemRoot> gStorage;
     std::mutex gStorageMutex;
+    // Also write every storage as "<id>.json", it is only read if the binary storage is missing or not valid.
+    std::atomic<bool> sExportJSON = false;
 
     namespace Helper {
         static WUPSStorageError ConvertToWUPSError(const StorageSubItem::StorageSubItemError &error) {
@@ -27,252 +34,279 @@ namespace StorageUtils {
             return WUPS_STORAGE_ERROR_UNKNOWN_ERROR;
         }
 
-        static bool deserializeFromJson(const nlohmann::json &json, StorageSubItem &item) {
-            for (auto it = json.begin(); it != json.end(); ++it) {
-                StorageSubItem::StorageSubItemError subItemError = StorageSubItem::STORAGE_SUB_ITEM_ERROR_NONE;
-                if (it.value().is_object()) {
-                    auto res = item.createSubItem(it.key().c_str(), subItemError);
-                    if (!res) {
-                        DEBUG_FUNCTION_LINE_WARN("Failed to create sub item: Error %d", subItemError);
-                        return false;
-                    }
-                    if (!it.value().empty()) {
-                        if (!deserializeFromJson(it.value(), *res)) {
-                            DEBUG_FUNCTION_LINE_WARN("Deserialization of sub item failed.");
-                            return false;
-                        }
-                    }
-                } else {
-                    auto res = item.createItem(it.key().c_str(), subItemError);
-
-                    if (!res) {
-                        DEBUG_FUNCTION_LINE_WARN("Failed to create Item for key %s. Error %d", it.key().c_str(), subItemError);
-                        return false;
-                    }
-                    if (it.value().is_string()) {
-                        auto val = it.value().get<std::string>();
-                        res->setValue(val);
-                    } else if (it.value().is_boolean()) {
-                        auto val = it.value().get<bool>();
-                        res->setValue(val);
-                    } else if (it.value().is_number_unsigned()) {
-                        auto val = it.value().get<std::uint64_t>();
-                        res->setValue(val);
-                    } else if (it.value().is_number_integer()) {
-                        auto val = it.value().get<std::int64_t>();
-                        res->setValue(val);
-                    } else if (it.value().is_number_float()) {
-                        auto val = it.value().get<std::double_t>();
-                        res->setValue(val);
-                    } else {
-                        DEBUG_FUNCTION_LINE_ERR("Unknown type %s for value %s", it.value().type_name(), it.key().c_str());
-                    }
-                }
-            }
-            return true;
+        static StorageItemRoot *getRootItem(wups_storage_root_item root) {
+            // Only roots are added to the handle table without a root.
+            return static_cast<StorageItemRoot *>(StorageHandleTable::Get((uint32_t) root, 0));
         }
 
-        static std::unique_ptr<StorageItemRoot> deserializeFromJson(const nlohmann::json &json, std::string_view key) {
-            if (json.empty() || !json.is_object()) {
-                return nullptr;
-            }
-            auto root = make_unique_nothrow<StorageItemRoot>(key);
-            if (root) {
-                if (deserializeFromJson(json, *root)) {
-                    return root;
+        static StorageSubItem *getSubItem(wups_storage_root_item root, wups_storage_item parent, StorageItemRoot *&outRootItem) {
+            outRootItem = getRootItem(root);
+            if (outRootItem) {
+                if (parent == nullptr) {
+                    return outRootItem;
                 }
+                return StorageHandleTable::Get((uint32_t) parent, (uint32_t) root);
             }
             return nullptr;
         }
 
-        static nlohmann::json serializeToJson(const StorageSubItem &baseItem) {
-            nlohmann::json json = nlohmann::json::object();
+        static StorageSubItem *getSubItem(wups_storage_root_item root, wups_storage_item parent) {
+            StorageItemRoot *rootItem;
+            return getSubItem(root, parent, rootItem);
+        }
 
-            for (const auto &curSubItem : baseItem.getSubItems()) {
-                json[curSubItem.getKey()] = serializeToJson(curSubItem);
-            }
+        static std::string GetStorageFilePath(std::string_view plugin_id, std::string_view extension) {
+            return getPluginPath() + "/config/" + plugin_id.data() + extension.data();
+        }
 
-            for (const auto &[key, value] : baseItem.getItems()) {
-                switch ((StorageItemType) value.getType()) {
-                    case StorageItemType::String: {
-                        std::string res;
-                        if (value.getValue(res)) {
-                            json[key] = res;
-                        }
-                        break;
-                    }
-                    case StorageItemType::Boolean: {
-                        bool res;
-                        if (value.getValue(res)) {
-                            json[key] = res;
-                        }
-                        break;
-                    }
-                    case StorageItemType::S64: {
-                        int64_t res;
-                        if (value.getValue(res)) {
-                            json[key] = res;
-                        }
-                        break;
-                    }
-                    case StorageItemType::U64: {
-                        uint64_t res;
-                        if (value.getValue(res)) {
-                            json[key] = res;
-                        }
-                        break;
-                    }
-                    case StorageItemType::Double: {
-                        double res;
-                        if (value.getValue(res)) {
-                            json[key] = res;
-                        }
-                        break;
-                    }
-                    case StorageItemType::Binary: {
-                        std::vector<uint8_t> tmp;
-                        if (value.getValue(tmp)) {
-                            auto *enc = b64_encode(tmp.data(), tmp.size());
-                            if (enc) {
-                                json[key] = enc;
-                                free(enc);
-                            } else {
-                                DEBUG_FUNCTION_LINE_WARN("Failed to store binary item: Malloc failed");
-                            }
-                        }
-                        break;
-                    }
-                    case StorageItemType::None:
-                        DEBUG_FUNCTION_LINE_WARN("Skip: StorageItemType::None");
-                        break;
-                }
+        static WUPSStorageError ReadStorageFile(const std::string &filePath, std::vector<uint8_t> &outBuffer) {
+            CFile file(filePath, CFile::ReadOnly);
+            if (!file.isOpen() || file.size() == 0) {
+                return WUPS_STORAGE_ERROR_NOT_FOUND;
             }
-
-            return json;
+            outBuffer.resize(file.size());
+            if (file.read(outBuffer.data(), outBuffer.size()) != (int32_t) outBuffer.size()) {
+                return WUPS_STORAGE_ERROR_IO_ERROR;
+            }
+            return WUPS_STORAGE_ERROR_SUCCESS;
         }
 
-        static StorageItemRoot *getRootItem(wups_storage_root_item root) {
-            for (auto &cur : gStorage) {
-                if (cur.getHandle() == (uint32_t) root) {
-                    return &cur;
+        /**
+         * Replaces the items of the root with the storage of "<filePath>".
+         *
+         * If the file is missing but "<filePath>.tmp" exists, a save was interrupted. The temporary file is complete if the
+         * old file had already been removed, but it might also be the cut off first save of this storage. So it's only
+         * restored if it is a valid storage, otherwise it's removed.
+         *
+         * @return WUPS_STORAGE_ERROR_UNEXPECTED_DATA_TYPE if the file is not a valid storage, the root is empty then.
+         */
+        static WUPSStorageError LoadStorageFile(const std::string &filePath, StorageItemRoot &rootItem, bool (*deserialize)(std::span<const uint8_t>, StorageSubItem &)) {
+            std::vector<uint8_t> buffer;
+            WUPSStorageError err = ReadStorageFile(filePath, buffer);
+            if (err == WUPS_STORAGE_ERROR_NOT_FOUND) {
+                std::string tmpPath = filePath + ".tmp";
+                if (ReadStorageFile(tmpPath, buffer) != WUPS_STORAGE_ERROR_SUCCESS) {
+                    return WUPS_STORAGE_ERROR_NOT_FOUND;
+                }
+                rootItem.wipe();
+                if (!deserialize(buffer, rootItem)) {
+                    DEBUG_FUNCTION_LINE_WARN("Removing incomplete \"%s\"", tmpPath.c_str());
+                    rootItem.wipe();
+                    remove(tmpPath.c_str());
+                    return WUPS_STORAGE_ERROR_NOT_FOUND;
+                }
+                if (FSUtils::ReplaceFile(tmpPath, filePath)) {
+                    DEBUG_FUNCTION_LINE_WARN("Restored \"%s\" from the temporary file", filePath.c_str());
                 }
+                return WUPS_STORAGE_ERROR_SUCCESS;
+            } else if (err != WUPS_STORAGE_ERROR_SUCCESS) {
+                return err;
             }
 
-            return nullptr;
+            rootItem.wipe();
+            if (!deserialize(buffer, rootItem)) {
+                rootItem.wipe();
+                return WUPS_STORAGE_ERROR_UNEXPECTED_DATA_TYPE;
+            }
+            return WUPS_STORAGE_ERROR_SUCCESS;
         }
 
-        static StorageSubItem *getSubItem(wups_storage_root_item root, wups_storage_item parent) {
-            auto rootItem = getRootItem(root);
-            if (rootItem) {
-                if (parent == nullptr) {
-                    return rootItem;
-                }
-                return rootItem->getSubItem(parent);
+        /**
+         * Streams the storage to "<filePath>.tmp" and replaces the file with it afterwards,
+         * so an interrupted save never leaves a truncated file behind.
+         */
+        static WUPSStorageError WriteStorageFile(const std::string &filePath, const StorageItemRoot &rootItem, bool (*serialize)(const StorageSubItem &, BufferedFileWriter &)) {
+            std::string tmpPath = filePath + ".tmp";
+            CFile file(tmpPath, CFile::WriteOnly);
+            if (!file.isOpen()) {
+                DEBUG_FUNCTION_LINE_ERR("Cannot create file %s", tmpPath.c_str());
+                return WUPS_STORAGE_ERROR_IO_ERROR;
             }
-            return nullptr;
-        }
 
-        WUPSStorageError LoadFromFile(std::string_view plugin_id, nlohmann::json &outJson) {
-            std::string filePath = getPluginPath() + "/config/" + plugin_id.data() + ".json";
-            CFile file(filePath, CFile::ReadOnly);
-            if (!file.isOpen() || file.size() == 0) {
-                return WUPS_STORAGE_ERROR_NOT_FOUND;
+            bool serialized;
+            bool written;
+            {
+                BufferedFileWriter writer(file);
+                serialized = serialize(rootItem, writer);
+                written    = writer.flush();
             }
-            auto *json_data = (uint8_t *) memalign(0x40, ROUNDUP(file.size() + 1, 0x40));
-            if (!json_data) {
-                return WUPS_STORAGE_ERROR_MALLOC_FAILED;
+
+            file.close();
+
+            if (!written || !serialized) {
+                remove(tmpPath.c_str());
+                if (!written) {
+                    return WUPS_STORAGE_ERROR_IO_ERROR;
+                }
+                DEBUG_FUNCTION_LINE_ERR("Failed to serialize storage \"%s\"", rootItem.getPluginId().c_str());
+                return WUPS_STORAGE_ERROR_UNKNOWN_ERROR;
             }
-            WUPSStorageError result = WUPS_STORAGE_ERROR_SUCCESS;
-            uint64_t readRes        = file.read(json_data, file.size());
-            if (readRes == file.size()) {
-                json_data[file.size()] = '\0';
-                outJson                = nlohmann::json::parse(json_data, nullptr, false);
-            } else {
-                result = WUPS_STORAGE_ERROR_IO_ERROR;
+            if (!FSUtils::ReplaceFile(tmpPath, filePath)) {
+                DEBUG_FUNCTION_LINE_ERR("Failed to replace %s", filePath.c_str());
+                return WUPS_STORAGE_ERROR_IO_ERROR;
             }
-            file.close();
-            free(json_data);
-            return result;
+            return WUPS_STORAGE_ERROR_SUCCESS;
         }
 
+        /**
+         * Storages used to be saved as "<id>.json", they are saved as binary storage on the next save.
+         * The JSON file is kept as a backup, it's only read if the binary storage is missing or not valid.
+         */
         WUPSStorageError LoadFromFile(std::string_view plugin_id, StorageItemRoot &rootItem) {
-            nlohmann::json j;
-            WUPSStorageError err;
-
-            if ((err = LoadFromFile(plugin_id, j)) != WUPS_STORAGE_ERROR_SUCCESS) {
+            WUPSStorageError err = LoadStorageFile(GetStorageFilePath(plugin_id, ".bin"), rootItem, &StorageBinaryFormat::Deserialize);
+            if (err == WUPS_STORAGE_ERROR_SUCCESS) {
+                rootItem.markClean();
+                return WUPS_STORAGE_ERROR_SUCCESS;
+            } else if (err != WUPS_STORAGE_ERROR_NOT_FOUND && err != WUPS_STORAGE_ERROR_UNEXPECTED_DATA_TYPE) {
                 return err;
             }
 
-            std::unique_ptr<StorageItemRoot> storage;
-            if (j.empty() || !j.is_object() || !j.contains("storageitems") || j["storageitems"].empty() || !j["storageitems"].is_object()) {
-                storage = make_unique_nothrow<StorageItemRoot>(plugin_id);
-            } else {
-                storage = StorageUtils::Helper::deserializeFromJson(j["storageitems"], plugin_id);
-                if (!storage) {
-                    storage = make_unique_nothrow<StorageItemRoot>(plugin_id);
+            bool binaryExists = err == WUPS_STORAGE_ERROR_UNEXPECTED_DATA_TYPE;
+            if (binaryExists) {
+                DEBUG_FUNCTION_LINE_WARN("\"%s.bin\" is not a valid storage, trying to load \"%s.json\"", rootItem.getPluginId().c_str(), rootItem.getPluginId().c_str());
+            }
+            err = LoadStorageFile(GetStorageFilePath(plugin_id, ".json"), rootItem, &StorageJSONFormat::Deserialize);
+            if (err == WUPS_STORAGE_ERROR_NOT_FOUND && !binaryExists) {
+                return WUPS_STORAGE_ERROR_NOT_FOUND;
+            } else if (err != WUPS_STORAGE_ERROR_SUCCESS) {
+                if (err != WUPS_STORAGE_ERROR_NOT_FOUND && err != WUPS_STORAGE_ERROR_UNEXPECTED_DATA_TYPE) {
+                    return err;
                 }
+                DEBUG_FUNCTION_LINE_WARN("No valid storage found for \"%s\", it will be replaced on the next save", rootItem.getPluginId().c_str());
+                rootItem.wipe();
             }
-            rootItem = std::move(*storage);
+            // Saves the storage as binary storage on the next save.
+            rootItem.markDirty();
             return WUPS_STORAGE_ERROR_SUCCESS;
         }
 
-        static WUPSStorageError WriteStorageToSD(wups_storage_root_item root, bool forceSave) {
-            const StorageItemRoot *rootItem = nullptr;
-            for (const auto &cur : gStorage) {
-                if (cur.getHandle() == (uint32_t) root) {
-                    rootItem = &cur;
-                    break;
-                }
+        static WUPSStorageError WriteSnapshotToSD(const StorageItemRoot &rootItem) {
+            if (!FSUtils::CreateSubfolder(getPluginPath() + "/config/")) {
+                return WUPS_STORAGE_ERROR_IO_ERROR;
             }
-            if (!rootItem) {
-                return WUPS_STORAGE_ERROR_INTERNAL_NOT_INITIALIZED;
+
+            WUPSStorageError err;
+            if ((err = WriteStorageFile(GetStorageFilePath(rootItem.getPluginId(), ".bin"), rootItem, &StorageBinaryFormat::Serialize)) != WUPS_STORAGE_ERROR_SUCCESS) {
+                return err;
             }
 
-            std::string folderPath = getPluginPath() + "/config/";
-            std::string filePath   = folderPath + rootItem->getPluginId() + ".json";
+            if (!sExportJSON) {
+                return WUPS_STORAGE_ERROR_SUCCESS;
+            }
+            return WriteStorageFile(GetStorageFilePath(rootItem.getPluginId(), ".json"), rootItem, &StorageJSONFormat::Serialize);
+        }
+    } // namespace Helper
 
-            nlohmann::json j;
-            j["storageitems"] = serializeToJson(*rootItem);
+    /**
+     * Writes storage snapshots on the I/O thread of the TaskRuntime, so saving only costs the caller a copy of the tree.
+     * Saving the same storage again before the previous snapshot has been written replaces that snapshot.
+     */
+    namespace Flusher {
+        std::mutex sPendingMutex;
+        std::map<std::string, std::unique_ptr<StorageItemRoot>, std::less<>> sPending;
+        bool sDrainScheduled = false;
+        // Held while a snapshot is taken out of sPending and written, so a snapshot is either still pending or on the SD card.
+        std::mutex sWriteMutex;
+
+        static void Write(const StorageItemRoot &snapshot) {
+            DEBUG_FUNCTION_LINE_VERBOSE("Writing \"%s.bin\"...", snapshot.getPluginId().c_str());
+            if (auto res = Helper::WriteSnapshotToSD(snapshot); res != WUPS_STORAGE_ERROR_SUCCESS) {
+                DEBUG_FUNCTION_LINE_ERR("Failed to save storage \"%s\": %s", snapshot.getPluginId().c_str(), WUPSStorageAPI_GetStatusStr(res));
+            }
+        }
 
-            if (!forceSave) {
-                nlohmann::json jsonFromFile;
-                WUPSStorageError loadErr;
-                if ((loadErr = Helper::LoadFromFile(rootItem->getPluginId(), jsonFromFile)) == WUPS_STORAGE_ERROR_SUCCESS) {
-                    if (j == jsonFromFile) {
-                        DEBUG_FUNCTION_LINE_VERBOSE("Storage has no changes, avoid saving \"%s.json\"", rootItem->getPluginId().c_str());
-                        return WUPS_STORAGE_ERROR_SUCCESS;
+        static void Drain() {
+            while (true) {
+                std::lock_guard writeLock(sWriteMutex);
+                std::unique_ptr<StorageItemRoot> snapshot;
+                {
+                    std::lock_guard lock(sPendingMutex);
+                    if (sPending.empty()) {
+                        sDrainScheduled = false;
+                        return;
                     }
-                } else if (loadErr != WUPS_STORAGE_ERROR_NOT_FOUND) {
-                    DEBUG_FUNCTION_LINE_WARN("Failed to load \"%s.json\"", rootItem->getPluginId().c_str());
+                    snapshot = std::move(sPending.extract(sPending.begin()).mapped());
                 }
-                DEBUG_FUNCTION_LINE_VERBOSE("Saving \"%s.json\"...", rootItem->getPluginId().c_str());
-            } else {
-                DEBUG_FUNCTION_LINE_VERBOSE("Force saving \"%s.json\"...", rootItem->getPluginId().c_str());
+                Write(*snapshot);
             }
+        }
 
-            if (!FSUtils::CreateSubfolder(folderPath)) {
-                return WUPS_STORAGE_ERROR_IO_ERROR;
+        static Task<> DrainAsync() {
+            co_await TaskRuntime::ScheduleIO();
+            Drain();
+        }
+
+        static void Queue(std::unique_ptr<StorageItemRoot> snapshot) {
+            bool scheduleDrain;
+            {
+                std::lock_guard lock(sPendingMutex);
+                std::string pluginId = snapshot->getPluginId();
+                sPending.insert_or_assign(std::move(pluginId), std::move(snapshot));
+                scheduleDrain = !std::exchange(sDrainScheduled, true);
+            }
+            // If the runtime is not running, Spawn writes the snapshot on this thread.
+            if (scheduleDrain && !TaskRuntime::Spawn(DrainAsync())) {
+                DEBUG_FUNCTION_LINE_WARN("Failed to start the storage flusher, saving synchronously");
+                Drain();
             }
+        }
 
-            CFile file(filePath, CFile::WriteOnly);
-            if (!file.isOpen()) {
-                DEBUG_FUNCTION_LINE_ERR("Cannot create file %s", filePath.c_str());
-                return WUPS_STORAGE_ERROR_IO_ERROR;
+        /**
+         * Blocks until all queued snapshots have been written.
+         */
+        static void Flush() {
+            Drain();
+        }
+
+        /**
+         * Blocks until the queued snapshot of a single storage has been written, snapshots of other storages stay queued.
+         */
+        static void Flush(std::string_view pluginId) {
+            std::lock_guard writeLock(sWriteMutex);
+            std::unique_ptr<StorageItemRoot> snapshot;
+            {
+                std::lock_guard lock(sPendingMutex);
+                if (auto it = sPending.find(pluginId); it != sPending.end()) {
+                    snapshot = std::move(sPending.extract(it).mapped());
+                }
+            }
+            if (snapshot) {
+                Write(*snapshot);
             }
+        }
+    } // namespace Flusher
 
-            std::string jsonString = j.dump(4, ' ', false, nlohmann::json::error_handler_t::ignore);
-            auto writeResult       = file.write((const uint8_t *) jsonString.c_str(), jsonString.size());
+    namespace Helper {
+        /**
+         * Queues a snapshot of the storage for writing, see Flusher.
+         */
+        static WUPSStorageError WriteStorageToSD(wups_storage_root_item root, bool forceSave) {
+            auto rootItem = getRootItem(root);
+            if (!rootItem) {
+                return WUPS_STORAGE_ERROR_INTERNAL_NOT_INITIALIZED;
+            }
 
-            file.close();
+            if (!forceSave) {
+                if (!rootItem->isDirty()) {
+                    DEBUG_FUNCTION_LINE_VERBOSE("Storage has no changes, avoid saving \"%s.bin\"", rootItem->getPluginId().c_str());
+                    return WUPS_STORAGE_ERROR_SUCCESS;
+                }
+                DEBUG_FUNCTION_LINE_VERBOSE("Saving \"%s.bin\"...", rootItem->getPluginId().c_str());
+            } else {
+                DEBUG_FUNCTION_LINE_VERBOSE("Force saving \"%s.bin\"...", rootItem->getPluginId().c_str());
+            }
 
-            if (writeResult != (int32_t) jsonString.size()) {
-                return WUPS_STORAGE_ERROR_IO_ERROR;
+            auto snapshot = make_unique_nothrow<StorageItemRoot>(*rootItem);
+            if (!snapshot) {
+                return WUPS_STORAGE_ERROR_MALLOC_FAILED;
             }
+            rootItem->markClean();
+            Flusher::Queue(std::move(snapshot));
             return WUPS_STORAGE_ERROR_SUCCESS;
         }
 
-        static StorageItem *createOrGetItem(wups_storage_root_item root, wups_storage_item parent, const char *key, WUPSStorageError &error) {
-            auto subItem = getSubItem(root, parent);
+        static StorageItem *createOrGetItem(wups_storage_root_item root, wups_storage_item parent, const char *key, WUPSStorageError &error, StorageItemRoot *&outRootItem) {
+            auto subItem = getSubItem(root, parent, outRootItem);
             if (!subItem) {
                 error = WUPS_STORAGE_ERROR_NOT_FOUND;
                 return {};
@@ -282,6 +316,8 @@ namespace StorageUtils {
             if (!res) {
                 if (!(res = subItem->createItem(key, subItemError))) {
                     error = StorageUtils::Helper::ConvertToWUPSError(subItemError);
+                } else {
+                    outRootItem->markDirty();
                 }
             }
             if (res) {
@@ -293,9 +329,13 @@ namespace StorageUtils {
         template<typename T>
         WUPSStorageError StoreItemGeneric(wups_storage_root_item root, wups_storage_item parent, const char *key, T value) {
             WUPSStorageError err;
-            auto item = createOrGetItem(root, parent, key, err);
+            StorageItemRoot *rootItem;
+            auto item = createOrGetItem(root, parent, key, err, rootItem);
             if (item && err == WUPS_STORAGE_ERROR_SUCCESS) {
-                item->setValue(value);
+                // Plugins often store all of their settings again, that alone doesn't need to be saved.
+                if (item->setValue(value)) {
+                    rootItem->markDirty();
+                }
                 return WUPS_STORAGE_ERROR_SUCCESS;
             }
             return err;
@@ -337,7 +377,7 @@ namespace StorageUtils {
         /**
         * Binary items are serialized as base64 encoded string. The first time they are read they'll get converted into binary data.
         */
-        WUPSStorageError GetAndFixBinaryItem(wups_storage_root_item root, wups_storage_item parent, const char *key, std::vector<uint8_t> &result) {
+        WUPSStorageError GetAndFixBinaryItem(wups_storage_root_item root, wups_storage_item parent, const char *key, std::span<const uint8_t> &result) {
             auto subItem = getSubItem(root, parent);
             if (!subItem) {
                 return WUPS_STORAGE_ERROR_NOT_FOUND;
@@ -357,15 +397,19 @@ namespace StorageUtils {
             return WUPS_STORAGE_ERROR_NOT_FOUND;
         }
 
+        /**
+         * The string and binary getters copy the value straight from the item into the buffer of the caller.
+         * The views are only valid while gStorageMutex is held.
+         */
         static WUPSStorageError GetStringItem(wups_storage_root_item root, wups_storage_item parent, const char *key, void *data, uint32_t maxSize, uint32_t *outSize) {
-            std::string tmp;
-            auto res = GetItemEx<std::string>(root, parent, key, tmp);
+            std::string_view value;
+            auto res = GetItemEx<std::string_view>(root, parent, key, value);
             if (res == WUPS_STORAGE_ERROR_SUCCESS) {
-                if (maxSize <= tmp.size()) { // maxSize needs to be bigger because of the null-terminator
+                if (maxSize <= value.size()) { // maxSize needs to be bigger because of the null-terminator
                     return WUPS_STORAGE_ERROR_BUFFER_TOO_SMALL;
                 }
-                strncpy((char *) data, tmp.c_str(), tmp.size());
-                ((char *) data)[maxSize - 1] = '\0';
+                memcpy(data, value.data(), value.size());
+                ((char *) data)[value.size()] = '\0';
                 if (outSize) {
                     *outSize = strlen((char *) data) + 1;
                 }
@@ -375,21 +419,21 @@ namespace StorageUtils {
         }
 
         static WUPSStorageError GetBinaryItem(wups_storage_root_item root, wups_storage_item parent, const char *key, const void *data, uint32_t maxSize, uint32_t *outSize) {
-            std::vector<uint8_t> tmp;
-            auto res = GetAndFixBinaryItem(root, parent, key, tmp);
+            std::span<const uint8_t> value;
+            auto res = GetAndFixBinaryItem(root, parent, key, value);
             if (res == WUPS_STORAGE_ERROR_SUCCESS) {
-                if (tmp.empty()) { // we need this to support getting empty std::vector
+                if (value.empty()) { // we need this to support getting empty std::vector
                     return WUPS_STORAGE_ERROR_SUCCESS;
                 }
                 if (data == nullptr) {
                     return WUPS_STORAGE_ERROR_INVALID_ARGS;
                 }
-                if (maxSize < tmp.size()) {
+                if (maxSize < value.size()) {
                     return WUPS_STORAGE_ERROR_BUFFER_TOO_SMALL;
                 }
-                memcpy((uint8_t *) data, tmp.data(), tmp.size());
+                memcpy((uint8_t *) data, value.data(), value.size());
                 if (outSize) {
-                    *outSize = tmp.size();
+                    *outSize = value.size();
                 }
                 return WUPS_STORAGE_ERROR_SUCCESS;
             }
@@ -401,20 +445,25 @@ namespace StorageUtils {
         namespace Internal {
             WUPSStorageError OpenStorage(std::string_view plugin_id, wups_storage_root_item &outItem) {
                 std::lock_guard lock(gStorageMutex);
+                // The storage might have been closed just before, its last snapshot needs to be on the SD card.
+                Flusher::Flush(plugin_id);
                 gStorage.emplace_front(plugin_id);
                 auto &root = gStorage.front();
 
+                // If no existing storage was found the new root stays empty and clean.
                 WUPSStorageError err = Helper::LoadFromFile(plugin_id, root);
-                if (err == WUPS_STORAGE_ERROR_NOT_FOUND) {
-                    // Create new clean StorageItemRoot if no existing storage was found
-                    root = StorageItemRoot(plugin_id);
-                } else if (err != WUPS_STORAGE_ERROR_SUCCESS) {
+                if (err != WUPS_STORAGE_ERROR_SUCCESS && err != WUPS_STORAGE_ERROR_NOT_FOUND) {
                     // Return on any other error
                     gStorage.pop_front();
                     return err;
                 }
 
-                outItem = (wups_storage_root_item) root.getHandle();
+                auto handle = root.getHandle(0);
+                if (handle == 0) {
+                    gStorage.pop_front();
+                    return WUPS_STORAGE_ERROR_MALLOC_FAILED;
+                }
+                outItem = (wups_storage_root_item) handle;
 
                 return WUPS_STORAGE_ERROR_SUCCESS;
             }
@@ -422,15 +471,42 @@ namespace StorageUtils {
             WUPSStorageError CloseStorage(wups_storage_root_item root) {
                 std::lock_guard lock(gStorageMutex);
 
-                auto res = StorageUtils::Helper::WriteStorageToSD(root, false);
-                // TODO: handle write error?
-
-                if (!remove_first_if(gStorage, [&root](auto &cur) { return cur.getHandle() == (uint32_t) root; })) {
+                auto rootItem = Helper::getRootItem(root);
+                if (!rootItem) {
                     DEBUG_FUNCTION_LINE_WARN("Failed to close storage: Not opened (\"%08X\")", root);
                     return WUPS_STORAGE_ERROR_NOT_FOUND;
                 }
+
+                WUPSStorageError res = WUPS_STORAGE_ERROR_SUCCESS;
+                DEBUG_FUNCTION_LINE_VERBOSE("Storage \"%s\" used %d bytes (peak %d bytes), %d bytes in %d heap allocations", rootItem->getPluginId().c_str(),
+                                            rootItem->getArena().getUsedBytes(), rootItem->getArena().getPeakUsedBytes(),
+                                            rootItem->getArena().getReservedBytes(), rootItem->getArena().getNumberOfHeapAllocations());
+
+                // The handles of the tree must not be used anymore, no matter if it's moved to the snapshot or destroyed.
+                rootItem->releaseHandles();
+                if (rootItem->isDirty()) {
+                    // The storage is removed anyway, move the tree into the snapshot instead of copying it.
+                    auto snapshot = make_unique_nothrow<StorageItemRoot>(std::move(*rootItem));
+                    if (snapshot) {
+                        Flusher::Queue(std::move(snapshot));
+                    } else {
+                        res = WUPS_STORAGE_ERROR_MALLOC_FAILED;
+                    }
+                } else {
+                    DEBUG_FUNCTION_LINE_VERBOSE("Storage has no changes, avoid saving \"%s.bin\"", rootItem->getPluginId().c_str());
+                }
+
+                remove_first_if(gStorage, [rootItem](auto &cur) { return &cur == rootItem; });
                 return res;
             }
+
+            void FlushStorage() {
+                Flusher::Flush();
+            }
+
+            void SetJSONExport(bool enabled) {
+                sExportJSON = enabled;
+            }
         } // namespace Internal
 
         WUPSStorageError SaveStorage(wups_storage_root_item root, bool force) {
@@ -446,6 +522,9 @@ namespace StorageUtils {
                 return WUPS_STORAGE_ERROR_INTERNAL_NOT_INITIALIZED;
             }
 
+            // Pending saves have to be written before the file can be read again.
+            Flusher::Flush(rootItem->getPluginId());
+
             WUPSStorageError result;
             if ((result = Helper::LoadFromFile(rootItem->getPluginId(), *rootItem)) != WUPS_STORAGE_ERROR_SUCCESS) {
                 return result;
@@ -471,14 +550,20 @@ namespace StorageUtils {
                 return WUPS_STORAGE_ERROR_INVALID_ARGS;
             }
             std::lock_guard lock(gStorageMutex);
-            auto subItem = StorageUtils::Helper::getSubItem(root, parent);
+            StorageItemRoot *rootItem;
+            auto subItem = StorageUtils::Helper::getSubItem(root, parent, rootItem);
             if (subItem) {
                 StorageSubItem::StorageSubItemError error = StorageSubItem::STORAGE_SUB_ITEM_ERROR_NONE;
                 auto res                                  = subItem->createSubItem(key, error);
                 if (!res) {
                     return StorageUtils::Helper::ConvertToWUPSError(error);
                 }
-                *outItem = (wups_storage_item) res->getHandle();
+                rootItem->markDirty();
+                auto handle = res->getHandle((uint32_t) root);
+                if (handle == 0) {
+                    return WUPS_STORAGE_ERROR_MALLOC_FAILED;
+                }
+                *outItem = (wups_storage_item) handle;
                 return WUPS_STORAGE_ERROR_SUCCESS;
             }
             return WUPS_STORAGE_ERROR_NOT_FOUND;
@@ -495,7 +580,11 @@ namespace StorageUtils {
                 if (!res) {
                     return WUPS_STORAGE_ERROR_NOT_FOUND;
                 }
-                *outItem = (wups_storage_item) res->getHandle();
+                auto handle = res->getHandle((uint32_t) root);
+                if (handle == 0) {
+                    return WUPS_STORAGE_ERROR_MALLOC_FAILED;
+                }
+                *outItem = (wups_storage_item) handle;
                 return WUPS_STORAGE_ERROR_SUCCESS;
             }
             return WUPS_STORAGE_ERROR_NOT_FOUND;
@@ -503,12 +592,14 @@ namespace StorageUtils {
 
         WUPSStorageError DeleteItem(wups_storage_root_item root, wups_storage_item parent, const char *key) {
             std::lock_guard lock(gStorageMutex);
-            auto subItem = StorageUtils::Helper::getSubItem(root, parent);
+            StorageItemRoot *rootItem;
+            auto subItem = StorageUtils::Helper::getSubItem(root, parent, rootItem);
             if (subItem) {
                 auto res = subItem->deleteItem(key);
                 if (!res) {
                     return WUPS_STORAGE_ERROR_NOT_FOUND;
                 }
+                rootItem->markDirty();
                 return WUPS_STORAGE_ERROR_SUCCESS;
             }
             return WUPS_STORAGE_ERROR_NOT_FOUND;
@@ -586,19 +677,20 @@ namespace StorageUtils {
                     if (data == nullptr) {
                         return WUPS_STORAGE_ERROR_INVALID_ARGS;
                     }
-                    std::string tmp = length > 0 ? std::string((const char *) data, length) : std::string();
+                    // The value is copied straight into the item, short strings are stored inline.
+                    std::string_view value((const char *) data, length);
 
-                    DEBUG_FUNCTION_LINE_VERBOSE("Store %s as string: %s", key, tmp.c_str());
-                    return StorageUtils::Helper::StoreItemGeneric<std::string>(root, parent, key, tmp);
+                    DEBUG_FUNCTION_LINE_VERBOSE("Store %s as string: %.*s", key, (int) value.size(), value.data());
+                    return StorageUtils::Helper::StoreItemGeneric<std::string_view>(root, parent, key, value);
                 }
                 case WUPS_STORAGE_ITEM_BINARY: {
                     if (data == nullptr && length > 0) {
                         return WUPS_STORAGE_ERROR_INVALID_ARGS;
                     }
-                    std::vector<uint8_t> tmp = (data != nullptr && length > 0) ? std::vector<uint8_t>((uint8_t *) data, ((uint8_t *) data) + length) : std::vector<uint8_t>();
+                    std::span<const uint8_t> value((const uint8_t *) data, data != nullptr ? length : 0);
 
-                    DEBUG_FUNCTION_LINE_VERBOSE("Store %s as binary: size %d", key, tmp.size());
-                    return StorageUtils::Helper::StoreItemGeneric<std::vector<uint8_t>>(root, parent, key, tmp);
+                    DEBUG_FUNCTION_LINE_VERBOSE("Store %s as binary: size %d", key, value.size());
+                    return StorageUtils::Helper::StoreItemGeneric<std::span<const uint8_t>>(root, parent, key, value);
                 }
                 case WUPS_STORAGE_ITEM_BOOL: {
                     if (data == nullptr || length != sizeof(bool)) {
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <string_view>
 #include <wups/storage.h>
 
 namespace StorageUtils::API {
     namespace Internal {
         WUPSStorageError OpenStorage(std::string_view plugin_id, wups_storage_root_item &outItem);
         WUPSStorageError CloseStorage(wups_storage_root_item item);
+
+        /**
+         * Blocks until all saved storages have been written to the SD card.
+         */
+        void FlushStorage();
+
+        /**
+         * Storages are saved as "<id>.bin", if enabled they are also exported to "<id>.json" (e.g. for debugging).
+         */
+        void SetJSONExport(bool enabled);
     } // namespace Internal
 
     WUPSStorageError SaveStorage(wups_storage_root_item root, bool force);
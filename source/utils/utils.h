@@ -49,6 +49,7 @@ void dumpHex(const void *data, size_t size);
 #endif
 
 template<class T, class... Args>
+    requires(!std::is_array_v<T>)
 std::unique_ptr<T> make_unique_nothrow(Args &&...args) noexcept(noexcept(T(std::forward<Args>(args)...))) {
     return std::unique_ptr<T>(new (std::nothrow) T(std::forward<Args>(args)...));
 }
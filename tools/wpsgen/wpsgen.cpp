@@ -0,0 +1,591 @@
+/****************************************************************************
+ * Generates synthetic .wps files with controlled characteristics, to measure
+ * how loading and linking scales with the size and shape of a plugin.
+ *
+ * The plugins are accepted by PluginMetaInformationFactory and
+ * PluginInformationFactory, but the generated code is NOT meant to be executed:
+ * they contain no hooks and no function patches.
+ ****************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zlib.h>
+
+// Needs <cstdint>
+#include "elfio/elf_types.hpp"
+
+using namespace ELFIO;
+
+namespace {
+    constexpr uint32_t R_PPC_ADDR32    = 1;
+    constexpr uint32_t R_PPC_ADDR16_LO = 4;
+    constexpr uint32_t R_PPC_ADDR16_HI = 5;
+    constexpr uint32_t R_PPC_ADDR16_HA = 6;
+    constexpr uint32_t R_PPC_REL24     = 10;
+
+    constexpr uint32_t TEXT_BASE   = 0x02000000;
+    constexpr uint32_t DATA_BASE   = 0x10000000;
+    constexpr uint32_t IMPORT_BASE = 0xC0000000;
+
+    constexpr uint32_t INSTR_NOP = 0x60000000;
+    constexpr uint32_t INSTR_BL  = 0x48000001;
+    constexpr uint32_t INSTR_LIS = 0x3C600000; // lis r3, 0
+    constexpr uint32_t INSTR_ORI = 0x60630000; // ori r3, r3, 0
+    constexpr uint32_t INSTR_BLR = 0x4E800020;
+
+    const char *const RPL_NAMES[] = {"coreinit", "gx2", "nsysnet", "vpad", "padscore", "sndcore2", "nn_ac", "nn_act", "proc_ui", "sysapp", "nn_save", "zlib125"};
+
+    struct Options {
+        std::string output;
+        std::string name            = "Synthetic plugin";
+        uint32_t textSections       = 4;
+        uint32_t textSectionSize    = 0x1000;
+        uint32_t dataSize           = 0x1000;
+        uint32_t bssSize            = 0x100;
+        uint32_t relocationsPerType = 64;
+        uint32_t imports            = 16;
+        uint32_t rpls               = 2;
+        uint32_t farBranches        = 8;
+        uint32_t farBranchTarget    = 0x60000000;
+        uint32_t functionSymbols    = 256;
+        uint32_t dataSymbols        = 16;
+        uint32_t compressedSections = 0;
+        uint32_t seed               = 1;
+    };
+
+    struct Section {
+        std::string name;
+        uint32_t type      = SHT_NULL;
+        uint32_t flags     = 0;
+        uint32_t address   = 0;
+        uint32_t link      = 0;
+        uint32_t info      = 0;
+        uint32_t align     = 1;
+        uint32_t entrySize = 0;
+        // Size of SHT_NOBITS sections, everything else uses data.size()
+        uint32_t noBitsSize = 0;
+        bool compress       = false;
+        std::vector<uint8_t> data;
+
+        [[nodiscard]] uint32_t size() const {
+            return type == SHT_NOBITS ? noBitsSize : (uint32_t) data.size();
+        }
+    };
+
+    struct Symbol {
+        std::string name;
+        uint32_t value;
+        uint32_t size;
+        uint8_t bind;
+        uint8_t type;
+        uint16_t sectionIndex;
+    };
+
+    struct Relocation {
+        uint32_t offset;
+        uint32_t symbol;
+        uint32_t type;
+        int32_t addend;
+    };
+
+    void Put16(std::vector<uint8_t> &buffer, uint32_t offset, uint16_t value) {
+        buffer[offset]     = value >> 8;
+        buffer[offset + 1] = value;
+    }
+
+    void Put32(std::vector<uint8_t> &buffer, uint32_t offset, uint32_t value) {
+        buffer[offset]     = value >> 24;
+        buffer[offset + 1] = value >> 16;
+        buffer[offset + 2] = value >> 8;
+        buffer[offset + 3] = value;
+    }
+
+    void Append16(std::vector<uint8_t> &buffer, uint16_t value) {
+        buffer.resize(buffer.size() + 2);
+        Put16(buffer, buffer.size() - 2, value);
+    }
+
+    void Append32(std::vector<uint8_t> &buffer, uint32_t value) {
+        buffer.resize(buffer.size() + 4);
+        Put32(buffer, buffer.size() - 4, value);
+    }
+
+    uint32_t AddString(std::vector<uint8_t> &table, std::string_view str) {
+        auto offset = (uint32_t) table.size();
+        table.insert(table.end(), str.begin(), str.end());
+        table.push_back('\0');
+        return offset;
+    }
+
+    uint32_t AlignUp(uint32_t value, uint32_t align) {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    // Small deterministic PRNG, so the same options always produce the same file.
+    class Random {
+    public:
+        explicit Random(uint32_t seed) : mState(seed != 0 ? seed : 1) {
+        }
+
+        uint32_t next(uint32_t bound) {
+            mState ^= mState << 13;
+            mState ^= mState >> 17;
+            mState ^= mState << 5;
+            return mState % bound;
+        }
+
+    private:
+        uint32_t mState;
+    };
+
+    // Same format as wiiu_zlib: big endian uncompressed size followed by the zlib stream.
+    bool Deflate(std::vector<uint8_t> &data) {
+        uLongf compressedSize = compressBound(data.size());
+        std::vector<uint8_t> result(4 + compressedSize);
+        Put32(result, 0, data.size());
+        if (compress2(result.data() + 4, &compressedSize, data.data(), data.size(), Z_BEST_COMPRESSION) != Z_OK) {
+            return false;
+        }
+        result.resize(4 + compressedSize);
+        data = std::move(result);
+        return true;
+    }
+
+    class PluginBuilder {
+    public:
+        explicit PluginBuilder(const Options &options) : mOptions(options), mRandom(options.seed) {
+        }
+
+        bool build() {
+            mSections.emplace_back(); // SHT_NULL
+            addTextSections();
+            addDataSections();
+            addMetaSection();
+            addImportSections();
+            addSymbols();
+            addRelocations();
+            return true;
+        }
+
+        bool write(const std::string &path);
+
+    private:
+        uint32_t instructionsPerSection() const {
+            // Every relocation in .text needs its own instruction, spread evenly over all text sections.
+            uint32_t total = mOptions.relocationsPerType * 4 + mOptions.farBranches + mOptions.imports + mOptions.functionSymbols;
+            return (total + mOptions.textSections - 1) / mOptions.textSections + 1;
+        }
+
+        void addTextSections() {
+            uint32_t sectionSize = std::max(mOptions.textSectionSize, AlignUp(instructionsPerSection() * 4, 0x20));
+            uint32_t address     = TEXT_BASE;
+            for (uint32_t i = 0; i < mOptions.textSections; i++) {
+                Section section;
+                section.name     = i == 0 ? ".text" : ".text." + std::to_string(i);
+                section.type     = SHT_PROGBITS;
+                section.flags    = SHF_ALLOC | SHF_EXECINSTR;
+                section.address  = address;
+                section.align    = 0x20;
+                section.compress = i < mOptions.compressedSections;
+                for (uint32_t j = 0; j < sectionSize / 4; j++) {
+                    Append32(section.data, INSTR_NOP);
+                }
+                mTextSections.push_back(mSections.size());
+                mTextCursor.push_back(0);
+                mSections.push_back(std::move(section));
+                address = AlignUp(address + sectionSize, 0x20);
+            }
+        }
+
+        void addDataSections() {
+            Section data;
+            data.name    = ".data";
+            data.type    = SHT_PROGBITS;
+            data.flags   = SHF_ALLOC | SHF_WRITE;
+            data.address = DATA_BASE;
+            data.align   = 0x20;
+            data.data.resize(std::max(mOptions.dataSize, AlignUp(mOptions.relocationsPerType * 4 + mOptions.dataSymbols * 4, 0x20)));
+            mDataSection = mSections.size();
+            mSections.push_back(std::move(data));
+
+            Section bss;
+            bss.name       = ".bss";
+            bss.type       = SHT_NOBITS;
+            bss.flags      = SHF_ALLOC | SHF_WRITE;
+            bss.address    = AlignUp(DATA_BASE + mSections[mDataSection].size(), 0x20);
+            bss.align      = 0x20;
+            bss.noBitsSize = mOptions.bssSize;
+            mSections.push_back(std::move(bss));
+        }
+
+        void addMetaSection() {
+            Section meta;
+            meta.name    = ".wups.meta";
+            meta.type    = SHT_PROGBITS;
+            meta.flags   = SHF_ALLOC;
+            meta.address = AlignUp(mSections.back().address + mSections.back().size(), 4);
+            meta.align   = 4;
+            for (const auto &entry : {"name=" + mOptions.name, std::string("author=wpsgen"), std::string("version=1.0"), std::string("license=GPL"),
+                                      std::string("buildtimestamp=1970-01-01T00:00:00Z"), std::string("description=Synthetic plugin for benchmarks"), std::string("wups=0.8.1")}) {
+                AddString(meta.data, entry);
+            }
+            mSections.push_back(std::move(meta));
+        }
+
+        void addImportSections() {
+            if (mOptions.imports == 0 || mOptions.rpls == 0) {
+                return;
+            }
+            uint32_t address = IMPORT_BASE;
+            for (uint32_t i = 0; i < mOptions.rpls; i++) {
+                uint32_t count = mOptions.imports / mOptions.rpls + (i < mOptions.imports % mOptions.rpls ? 1 : 0);
+                std::string rplName;
+                if (i < std::size(RPL_NAMES)) {
+                    rplName = RPL_NAMES[i];
+                } else {
+                    rplName = "rpl" + std::to_string(i);
+                }
+                Section section;
+                section.name    = ".fimport_" + rplName;
+                section.type    = SHT_RPL_IMPORTS;
+                section.flags   = SHF_ALLOC | SHF_EXECINSTR;
+                section.address = address;
+                section.align   = 4;
+                // Header (number of imports, signature) followed by one 8 byte stub per import.
+                Append32(section.data, count);
+                Append32(section.data, 0);
+                for (uint32_t j = 0; j < count; j++) {
+                    Append32(section.data, 0);
+                    Append32(section.data, 0);
+                }
+                mImportSections.push_back({.sectionIndex = (uint32_t) mSections.size(), .count = count, .rplName = rplName});
+                address = AlignUp(address + section.size(), 0x20);
+                mSections.push_back(std::move(section));
+            }
+        }
+
+        void addSymbols() {
+            mSymbols.push_back({});
+            // One section symbol per loaded section, symbol i refers to section i. This also makes sure the sh_info
+            // (first global symbol) of .symtab is bigger than the index of any section that is linked, the loader
+            // looks up relocation sections by their sh_info.
+            for (uint32_t i = 1; i < mSections.size(); i++) {
+                mSymbols.push_back({.name = "", .value = mSections[i].address, .size = 0, .bind = STB_LOCAL, .type = STT_SECTION, .sectionIndex = (uint16_t) i});
+            }
+            mFarSymbol = mSymbols.size();
+            mSymbols.push_back({.name = "far_branch_target", .value = 0, .size = 0, .bind = STB_LOCAL, .type = STT_NOTYPE, .sectionIndex = (uint16_t) SHN_ABS});
+            mFirstGlobalSymbol = mSymbols.size();
+
+            // Functions are spread evenly over the text sections, each one is a single blr.
+            for (uint32_t i = 0; i < mOptions.functionSymbols; i++) {
+                auto textIndex   = i % mTextSections.size();
+                auto &section    = mSections[mTextSections[textIndex]];
+                uint32_t offset  = takeInstruction(textIndex);
+                Put32(section.data, offset, INSTR_BLR);
+                mFunctionSymbols.push_back(mSymbols.size());
+                mSymbols.push_back({.name = "synthetic_function_" + std::to_string(i), .value = section.address + offset, .size = 4, .bind = STB_GLOBAL, .type = STT_FUNC, .sectionIndex = (uint16_t) mTextSections[textIndex]});
+            }
+            if (mFunctionSymbols.empty()) {
+                mFunctionSymbols.push_back(mTextSections[0]); // section symbol of .text
+            }
+
+            // Data objects are placed behind the ADDR32 relocation targets.
+            const auto &data = mSections[mDataSection];
+            for (uint32_t i = 0; i < mOptions.dataSymbols; i++) {
+                mDataSymbols.push_back(mSymbols.size());
+                mSymbols.push_back({.name = "synthetic_data_" + std::to_string(i), .value = data.address + mOptions.relocationsPerType * 4 + i * 4, .size = 4, .bind = STB_GLOBAL, .type = STT_OBJECT, .sectionIndex = (uint16_t) mDataSection});
+            }
+            if (mDataSymbols.empty()) {
+                mDataSymbols.push_back(mDataSection); // section symbol of .data
+            }
+
+            for (const auto &importSection : mImportSections) {
+                const auto &section = mSections[importSection.sectionIndex];
+                for (uint32_t j = 0; j < importSection.count; j++) {
+                    mImportSymbols.push_back(mSymbols.size());
+                    mSymbols.push_back({.name = importSection.rplName + "_import_" + std::to_string(j), .value = section.address + 8 + j * 8, .size = 0, .bind = STB_GLOBAL, .type = STT_FUNC, .sectionIndex = (uint16_t) importSection.sectionIndex});
+                }
+            }
+        }
+
+        void addRelocations() {
+            mTextRelocations.resize(mTextSections.size());
+            for (uint32_t i = 0; i < mOptions.relocationsPerType; i++) {
+                // lis r3, data@ha / ori r3, r3, data@lo / lis r3, data@h
+                auto dataSymbol = mDataSymbols[mRandom.next(mDataSymbols.size())];
+                addTextRelocation(INSTR_LIS, 2, dataSymbol, R_PPC_ADDR16_HA, 0);
+                addTextRelocation(INSTR_ORI, 2, dataSymbol, R_PPC_ADDR16_LO, 0);
+                addTextRelocation(INSTR_LIS, 2, dataSymbol, R_PPC_ADDR16_HI, 0);
+                // bl to a random function
+                addTextRelocation(INSTR_BL, 0, mFunctionSymbols[mRandom.next(mFunctionSymbols.size())], R_PPC_REL24, 0);
+                // function pointer in .data
+                mDataRelocations.push_back({.offset = DATA_BASE + i * 4, .symbol = mFunctionSymbols[mRandom.next(mFunctionSymbols.size())], .type = R_PPC_ADDR32, .addend = 0});
+            }
+            // Branches that are out of range for a 24 bit relative branch, they are linked via a trampoline.
+            for (uint32_t i = 0; i < mOptions.farBranches; i++) {
+                addTextRelocation(INSTR_BL, 0, mFarSymbol, R_PPC_REL24, (int32_t) (mOptions.farBranchTarget + i * 4));
+            }
+            for (auto importSymbol : mImportSymbols) {
+                addTextRelocation(INSTR_BL, 0, importSymbol, R_PPC_REL24, 0);
+            }
+        }
+
+        uint32_t takeInstruction(uint32_t textIndex) {
+            auto offset = mTextCursor[textIndex];
+            mTextCursor[textIndex] += 4;
+            return offset;
+        }
+
+        void addTextRelocation(uint32_t instruction, uint32_t fieldOffset, uint32_t symbol, uint32_t type, int32_t addend) {
+            auto textIndex = mRandom.next(mTextSections.size());
+            // The sections are sized for an even spread, continue with the next one if the chosen one is full.
+            while (mTextCursor[textIndex] + 4 > mSections[mTextSections[textIndex]].size()) {
+                textIndex = (textIndex + 1) % mTextSections.size();
+            }
+            auto &section   = mSections[mTextSections[textIndex]];
+            uint32_t offset = takeInstruction(textIndex);
+            Put32(section.data, offset, instruction);
+            mTextRelocations[textIndex].push_back({.offset = section.address + offset + fieldOffset, .symbol = symbol, .type = type, .addend = addend});
+        }
+
+        struct ImportSection {
+            uint32_t sectionIndex;
+            uint32_t count;
+            std::string rplName;
+        };
+
+        const Options &mOptions;
+        Random mRandom;
+        std::vector<Section> mSections;
+        std::vector<uint32_t> mTextSections;
+        std::vector<uint32_t> mTextCursor;
+        uint32_t mDataSection     = 0;
+        std::vector<ImportSection> mImportSections;
+
+        std::vector<Symbol> mSymbols;
+        uint32_t mFarSymbol         = 0;
+        uint32_t mFirstGlobalSymbol = 0;
+        std::vector<uint32_t> mFunctionSymbols;
+        std::vector<uint32_t> mDataSymbols;
+        std::vector<uint32_t> mImportSymbols;
+
+        std::vector<std::vector<Relocation>> mTextRelocations;
+        std::vector<Relocation> mDataRelocations;
+    };
+
+    bool PluginBuilder::write(const std::string &path) {
+        auto addRelocationSection = [this](const std::string &name, uint32_t target, const std::vector<Relocation> &relocations, uint32_t symtabIndex) {
+            Section section;
+            section.name      = ".rela" + name;
+            section.type      = SHT_RELA;
+            section.flags     = SHF_INFO_LINK;
+            section.link      = symtabIndex;
+            section.info      = target;
+            section.align     = 4;
+            section.entrySize = 12;
+            for (const auto &relocation : relocations) {
+                Append32(section.data, relocation.offset);
+                Append32(section.data, (relocation.symbol << 8) | relocation.type);
+                Append32(section.data, (uint32_t) relocation.addend);
+            }
+            mSections.push_back(std::move(section));
+        };
+
+        // .rela.* sections, .symtab, .strtab, .shstrtab
+        uint32_t symtabIndex = mSections.size() + mTextSections.size() + 1;
+        for (uint32_t i = 0; i < mTextSections.size(); i++) {
+            auto target = mTextSections[i];
+            addRelocationSection(mSections[target].name, target, mTextRelocations[i], symtabIndex);
+        }
+        addRelocationSection(".data", mDataSection, mDataRelocations, symtabIndex);
+
+        Section strtab;
+        strtab.name = ".strtab";
+        strtab.type = SHT_STRTAB;
+        strtab.data.push_back('\0');
+
+        Section symtab;
+        symtab.name      = ".symtab";
+        symtab.type      = SHT_SYMTAB;
+        symtab.link      = symtabIndex + 1;
+        symtab.info      = mFirstGlobalSymbol;
+        symtab.align     = 4;
+        symtab.entrySize = 16;
+        for (const auto &symbol : mSymbols) {
+            Append32(symtab.data, symbol.name.empty() ? 0 : AddString(strtab.data, symbol.name));
+            Append32(symtab.data, symbol.value);
+            Append32(symtab.data, symbol.size);
+            symtab.data.push_back((symbol.bind << 4) | symbol.type);
+            symtab.data.push_back(0);
+            Append16(symtab.data, symbol.sectionIndex);
+        }
+        mSections.push_back(std::move(symtab));
+        mSections.push_back(std::move(strtab));
+
+        Section shstrtab;
+        shstrtab.name = ".shstrtab";
+        shstrtab.type = SHT_STRTAB;
+        mSections.push_back(std::move(shstrtab));
+
+        std::vector<uint32_t> nameOffsets;
+        auto &names = mSections.back().data;
+        names.push_back('\0');
+        for (const auto &section : mSections) {
+            nameOffsets.push_back(section.name.empty() ? 0 : AddString(names, section.name));
+        }
+
+        for (auto &section : mSections) {
+            if (section.compress) {
+                if (!Deflate(section.data)) {
+                    fprintf(stderr, "Failed to compress %s\n", section.name.c_str());
+                    return false;
+                }
+                section.flags |= SHF_RPX_DEFLATE;
+            }
+        }
+
+        // ELF header, section data, section header table
+        std::vector<uint8_t> file(0x34);
+        std::vector<uint32_t> offsets;
+        for (const auto &section : mSections) {
+            if (section.type == SHT_NULL || section.type == SHT_NOBITS) {
+                offsets.push_back(0);
+                continue;
+            }
+            file.resize(AlignUp(file.size(), std::max(section.align, 4u)));
+            offsets.push_back(file.size());
+            file.insert(file.end(), section.data.begin(), section.data.end());
+        }
+        file.resize(AlignUp(file.size(), 4));
+        uint32_t sectionHeaderOffset = file.size();
+        for (uint32_t i = 0; i < mSections.size(); i++) {
+            const auto &section = mSections[i];
+            Append32(file, nameOffsets[i]);
+            Append32(file, section.type);
+            Append32(file, section.flags);
+            Append32(file, section.address);
+            Append32(file, offsets[i]);
+            Append32(file, section.size());
+            Append32(file, section.link);
+            Append32(file, section.info);
+            Append32(file, section.type == SHT_NULL ? 0 : section.align);
+            Append32(file, section.entrySize);
+        }
+
+        const uint8_t ident[EI_NIDENT] = {ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3, ELFCLASS32, ELFDATA2MSB, EV_CURRENT, ELFOSABI_NONE};
+        memcpy(file.data(), ident, sizeof(ident));
+        Put16(file, 0x10, ET_EXEC);
+        Put16(file, 0x12, EM_PPC);
+        Put32(file, 0x14, EV_CURRENT);
+        Put32(file, 0x18, 0);                   // e_entry
+        Put32(file, 0x1C, 0);                   // e_phoff
+        Put32(file, 0x20, sectionHeaderOffset); // e_shoff
+        Put32(file, 0x24, 0);                   // e_flags
+        Put16(file, 0x28, 0x34);                // e_ehsize
+        Put16(file, 0x2A, 0);                   // e_phentsize
+        Put16(file, 0x2C, 0);                   // e_phnum
+        Put16(file, 0x2E, 40);                  // e_shentsize
+        Put16(file, 0x30, mSections.size());    // e_shnum
+        Put16(file, 0x32, mSections.size() - 1); // e_shstrndx
+
+        FILE *f = fopen(path.c_str(), "wb");
+        if (f == nullptr) {
+            fprintf(stderr, "Failed to open %s\n", path.c_str());
+            return false;
+        }
+        bool res = fwrite(file.data(), 1, file.size(), f) == file.size();
+        fclose(f);
+        if (!res) {
+            fprintf(stderr, "Failed to write %s\n", path.c_str());
+            return false;
+        }
+
+        uint32_t relocationCount = mDataRelocations.size();
+        for (const auto &relocations : mTextRelocations) {
+            relocationCount += relocations.size();
+        }
+        printf("%s: %u sections, %u symbols, %u relocations, %u bytes\n", path.c_str(), (uint32_t) mSections.size(), (uint32_t) mSymbols.size(), relocationCount, (uint32_t) file.size());
+        return true;
+    }
+
+    void PrintUsage(const char *argv0) {
+        fprintf(stderr,
+                "Usage: %s [options] -o <output.wps>\n"
+                "  --name <string>            plugin name\n"
+                "  --sections <n>             number of .text sections (default 4)\n"
+                "  --section-size <bytes>     minimum size of each .text section (default 0x1000)\n"
+                "  --data-size <bytes>        minimum size of .data (default 0x1000)\n"
+                "  --relocations <m>          internal relocations per type (ADDR32, ADDR16_LO/HI/HA, REL24) (default 64)\n"
+                "  --imports <k>              number of imported functions (default 16)\n"
+                "  --rpls <r>                 number of RPLs the imports are spread over (default 2)\n"
+                "  --far-branches <f>         branches that need a trampoline (default 8)\n"
+                "  --far-target <address>     absolute target of the far branches (default 0x60000000)\n"
+                "  --symbols <s>              number of function symbols (default 256)\n"
+                "  --data-symbols <d>         number of data symbols (default 16)\n"
+                "  --compressed <c>           number of .text sections that are stored compressed (default 0)\n"
+                "  --seed <seed>              seed for choosing relocation targets (default 1)\n",
+                argv0);
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        auto number       = (uint32_t) strtoul(value, nullptr, 0);
+        if (arg == "-o") {
+            options.output = value;
+        } else if (arg == "--name") {
+            options.name = value;
+        } else if (arg == "--sections") {
+            options.textSections = std::max(number, 1u);
+        } else if (arg == "--section-size") {
+            options.textSectionSize = number;
+        } else if (arg == "--data-size") {
+            options.dataSize = number;
+        } else if (arg == "--relocations") {
+            options.relocationsPerType = number;
+        } else if (arg == "--imports") {
+            options.imports = number;
+        } else if (arg == "--rpls") {
+            options.rpls = number;
+        } else if (arg == "--far-branches") {
+            options.farBranches = number;
+        } else if (arg == "--far-target") {
+            options.farBranchTarget = number & ~3u;
+        } else if (arg == "--symbols") {
+            options.functionSymbols = number;
+        } else if (arg == "--data-symbols") {
+            options.dataSymbols = number;
+        } else if (arg == "--compressed") {
+            options.compressedSections = number;
+        } else if (arg == "--seed") {
+            options.seed = number;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.output.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    PluginBuilder builder(options);
+    if (!builder.build() || !builder.write(options.output)) {
+        return 1;
+    }
+    return 0;
+}